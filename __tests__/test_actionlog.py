@@ -0,0 +1,118 @@
+import pytest
+import json
+from hanasim import hanasim as hs
+from hanasim import actionlog
+
+
+@pytest.fixture()
+def game():
+    """Setup a 3-player game with a deck ordered by colour and rank"""
+
+    game = hs.Board(3, list(hs.DECK))
+    game.setup()
+    return game
+
+
+def test_encode_roundtrip():
+    """Test that records pack and unpack all fields"""
+
+    actions = [
+        (hs.PLAY, 4, 49, 4, 3),
+        (hs.HINTRANK, 2, 1, 5, 0),
+        (hs.ENDGAME, 0, 0, 2, 0),
+    ]
+    for action in actions:
+        record = hs.encode_action(*action)
+        assert record < 2**18
+        assert hs.decode_action(record) == action
+
+
+def test_action_log_growth():
+    """Test that the log grows beyond its preallocated buffer"""
+
+    log = hs.ActionLog()
+    for i in range(hs.MAXRECORDS + 3):
+        log.append(i)
+    assert len(log) == hs.MAXRECORDS + 3
+    assert list(log)[-1] == hs.MAXRECORDS + 2
+
+    log.clear()
+    assert len(log) == 0
+
+
+def test_board_log(game):
+    """Test the records a board logs for each action type"""
+
+    # Player 0 holds W1 W1 W1 W2 W2 and plays deck card 1
+    game.resolve_move(0, (hs.PLAY, 1, hs.WHITE))
+    game.resolve_move(1, (hs.DISCARD, 0, None))
+    game.resolve_move(2, (hs.HINTCOLOUR, 0, hs.WHITE))
+    game.resolve_move(0, (hs.HINTRANK, 1, 2))
+
+    assert game.action_history == [
+        (hs.PLAY, 0, 1, hs.WHITE, 1),
+        (hs.DISCARD, 1, 5, 0, 0),
+        (hs.HINTCOLOUR, 2, 0, hs.WHITE, 0),
+        (hs.HINTRANK, 0, 1, 2, 0),
+    ]
+
+
+def test_board_log_strikeout(game):
+    """Test that a game over record ends a struck out game"""
+
+    # Player 0 misplays W2 three times
+    for _ in range(3):
+        game.resolve_move(0, (hs.PLAY, 3, hs.WHITE))
+
+    assert game.game_over
+    assert game.action_history[-1] == (hs.ENDGAME, 0, 0, hs.END_STRIKEOUT, 0)
+    assert len(game.action_log) == 4
+
+
+def test_writer_roundtrip(game, tmp_path):
+    """Test that logs of several games are appended to one file"""
+
+    game.resolve_move(0, (hs.PLAY, 0, hs.WHITE))
+    game.resolve_move(1, (hs.DISCARD, 2, None))
+
+    path = str(tmp_path / "games.log")
+    with actionlog.LogWriter(path) as writer:
+        writer.write(7, game.action_log.view())
+        writer.write(8, hs.ActionLog().view())
+    with actionlog.LogWriter(path) as writer:
+        writer.write(1 << 40, game.action_log.view())
+
+    # Logs packed by a worker are appended as they are
+    chunk = actionlog.pack_log(3, game.action_log.view())
+    chunk += actionlog.pack_log(4, hs.ActionLog().view())
+    with actionlog.LogWriter(path) as writer:
+        writer.write_packed(chunk)
+
+    logs = list(actionlog.read_logs(path))
+    assert [index for index, _ in logs] == [7, 8, 1 << 40, 3, 4]
+    assert list(logs[0][1]) == list(logs[3][1]) == list(game.action_log)
+    assert len(logs[1][1]) == len(logs[4][1]) == 0
+
+    with open(path, "ab") as f:
+        f.write(b"\x01\x02")
+    with pytest.raises(ValueError):
+        list(actionlog.read_logs(path))
+
+
+def test_hanab_live(game):
+    """Test conversion of a game into the hanab.live format"""
+
+    game.resolve_move(0, (hs.PLAY, 0, hs.WHITE))
+    game.resolve_move(1, (hs.HINTRANK, 2, 3))
+
+    codes = [hs.card_code(card) for card in game.deck]
+    export = actionlog.to_hanab_live(codes, game.action_log, 3)
+    assert export["players"] == ["Player 0", "Player 1", "Player 2"]
+    assert export["deck"][0] == {"suitIndex": 0, "rank": 1}
+    assert export["deck"][49] == {"suitIndex": 4, "rank": 5}
+    assert export["actions"] == [
+        {"type": 0, "target": 0},
+        {"type": 3, "target": 2, "value": 3},
+    ]
+    dump = actionlog.dumps_hanab_live(game.deck, game.action_log, 3)
+    assert json.loads(dump) == export
@@ -0,0 +1,217 @@
+import pytest
+import random
+import numpy as np
+from hanasim import hanasim as hs
+from hanasim import batch as hb
+from hanasim.packed import PackedBoard
+from agents import cheat_tobin, cheater_discard_first
+
+
+def reference_games(batch):
+    """Set up one PackedBoard per game of a batch with the same deck"""
+
+    games = []
+    for deck in batch.decks:
+        game = PackedBoard(batch.num_players, [hs.CARDS[code] for code in deck])
+        game.setup()
+        games.append(game)
+
+    return games
+
+
+def random_move(game, player_id, rng):
+    """Pick a random legal move"""
+
+    hand = game.get_hand(player_id, (player_id + 1) % game.num_players)
+    target = rng.randrange(len(hand))
+    choice = rng.random()
+    if choice < 0.4:
+        return (hs.PLAY, target, hand[target].colour)
+    if choice < 0.6:
+        return (hs.PLAY, target, rng.choice(hs.COLOURS))
+    if choice < 0.9 or game.num_hints == 0:
+        return (hs.DISCARD, target, 0)
+    other = (player_id + 1) % game.num_players
+    return (rng.choice([hs.HINTCOLOUR, hs.HINTRANK]), other, 1)
+
+
+def assert_same_state(batch, games):
+    for n, game in enumerate(games):
+        assert batch.game_over[n] == game.game_over
+        assert batch.score[n] == game.score
+        assert batch.num_hints[n] == game.num_hints
+        assert batch.num_strikes[n] == game.num_strikes
+        assert batch.turn[n] == game.turn
+        assert list(batch.fireworks[n]) == game.fireworks
+        assert list(batch.discard_pile[n]) == game._discards
+        assert batch.played[n] == game._played
+        assert batch.dead[n] == game._dead
+        assert batch.useless[n] == game._useless
+        assert batch.max_score[n] == game.max_score
+        assert batch.pace[n] == game.pace
+        assert batch.critical[n] == game._critical
+        assert batch.playable[n] == game._playable
+        assert list(batch.game_log(n)) == list(game.action_log)
+        for player_id, masks in enumerate(game.slot_masks):
+            empty = [0] * (batch.handsize - len(masks))
+            assert list(batch.slot_masks[n, player_id]) == masks + empty
+
+
+def test_setup():
+    """Test that all games are dealt like Board.deal"""
+
+    batch = hb.BatchBoard(16, 4)
+    batch.generate_decks(np.random.default_rng(0))
+    batch.setup()
+
+    assert batch.decks.shape == (16, 50)
+    for deck in batch.decks:
+        assert sorted(deck) == sorted(hb.DECK_CODES)
+    assert np.all(batch.index == 16)
+    assert np.all(batch.hand_sizes == 4)
+    assert list(batch.hands[3, 1]) == [4, 5, 6, 7]
+    assert list(batch.hand_cards(np.full(16, 2))[5]) == list(batch.decks[5, 8:12])
+    assert_same_state(batch, reference_games(batch))
+
+
+@pytest.mark.parametrize("num_players", [2, 3, 4, 5])
+def test_matches_board(num_players):
+    """Test that a batch plays out exactly like individual boards"""
+
+    num_games = 32
+    rng = random.Random(num_players)
+    batch = hb.BatchBoard(num_games, num_players)
+    batch.generate_decks(np.random.default_rng(num_players))
+    batch.setup()
+    games = reference_games(batch)
+
+    while not batch.game_over.all():
+        moves = np.zeros((3, num_games), dtype=int)
+        for n, game in enumerate(games):
+            if not game.game_over:
+                player_id = game.turn % num_players
+                moves[:, n] = random_move(game, player_id, rng)
+                game.resolve_move(player_id, tuple(moves[:, n].tolist()))
+
+        batch.resolve_moves(*moves)
+        assert_same_state(batch, games)
+
+
+def test_reset_games():
+    """Test that reset games are dealt like new boards, the others untouched"""
+
+    batch = hb.BatchBoard(8, 3)
+    batch.generate_decks(np.random.default_rng(2))
+    batch.setup()
+    agent = cheater_discard_first.BatchAgent()
+    hb.play_batch(batch, agent)
+    scores = batch.score.copy()
+
+    rows = np.array([1, 4, 6])
+    decks = hb.BatchBoard(3, 3)
+    decks.generate_decks(np.random.default_rng(3))
+    batch.reset_games(rows, decks.decks)
+    assert list(batch.score[rows]) == [0, 0, 0]
+    assert np.all(batch.game_over == np.isin(np.arange(8), rows, invert=True))
+
+    games = reference_games(batch)
+    for n in rows:
+        assert batch.turn[n] == 0
+        assert list(batch.hands[n].ravel()) == list(range(15))
+        assert np.array_equal(batch.decks[n], decks.decks[list(rows).index(n)])
+
+    # Only the reset games are played on
+    hb.play_batch(batch, agent)
+    for n, game in enumerate(games):
+        if n in rows:
+            hs.play_game(game, [cheater_discard_first.Agent(i, game) for i in range(3)])
+            assert batch.score[n] == game.score
+        else:
+            assert batch.score[n] == scores[n]
+
+
+def test_invalid_moves():
+    """Test that illegal moves in live games are rejected"""
+
+    batch = hb.BatchBoard(2, 2)
+    batch.setup()
+    zeros = np.zeros(2, dtype=int)
+
+    with pytest.raises(ValueError):
+        batch.resolve_moves(np.full(2, hs.ENDGAME), zeros, zeros)
+    with pytest.raises(ValueError):
+        batch.resolve_moves(np.full(2, hs.HINTCOLOUR), zeros, zeros)
+    with pytest.raises(ValueError):
+        batch.resolve_moves(zeros, np.full(2, 5), zeros)
+    with pytest.raises(ValueError):
+        batch.resolve_moves(np.full(2, hs.HINTRANK), np.ones(2, dtype=int), zeros)
+
+    # Moves of finished games are ignored
+    batch.game_over[:] = True
+    batch.resolve_moves(np.full(2, hs.ENDGAME), zeros, zeros)
+    assert np.all(batch.turn == 0)
+
+
+def test_batch_agent():
+    """Test the vectorized discard-first agent against its scalar rules"""
+
+    num_games = 64
+    batch = hb.BatchBoard(num_games, 3)
+    batch.generate_decks(np.random.default_rng(1))
+    batch.setup()
+    games = reference_games(batch)
+    agent = cheater_discard_first.BatchAgent()
+
+    while not batch.game_over.all():
+        action_types, targets, values = agent.find_moves(batch)
+        for n, game in enumerate(games):
+            if game.game_over:
+                continue
+            player_id = game.turn % 3
+            hand = [game.deck[i] for i in game.player_hands[player_id]]
+            playable = [i for i, card in enumerate(hand) if card in game.playable_cards]
+            if playable:
+                expected = (hs.PLAY, playable[0], hand[playable[0]].colour)
+            else:
+                expected = (hs.DISCARD, 0, 0)
+            assert (action_types[n], targets[n], values[n]) == expected
+            game.resolve_move(player_id, expected)
+
+        batch.resolve_moves(action_types, targets, values)
+
+    scores = hb.play_batch(batch, agent)
+    assert list(scores) == [game.score for game in games]
+
+
+@pytest.mark.parametrize("num_players", [2, 3, 4, 5])
+def test_tobin_batch_agent(num_players):
+    """Test that the vectorized Tobin agent moves like the reference agent"""
+
+    num_games = 64
+    batch = hb.BatchBoard(num_games, num_players)
+    batch.generate_decks(np.random.default_rng(num_players))
+    batch.setup()
+    games = reference_games(batch)
+    players = [
+        [cheat_tobin.Agent(i, game) for i in range(num_players)] for game in games
+    ]
+    agent = cheat_tobin.BatchAgent()
+
+    while not batch.game_over.all():
+        action_types, targets, values = agent.find_moves(batch)
+        for n, game in enumerate(games):
+            if game.game_over:
+                continue
+            player_id = game.turn % num_players
+            action_type, target, value = players[n][player_id].find_move(game)
+            expected = (action_type, target, value or 0)
+            assert (action_types[n], targets[n], values[n]) == expected
+            game.resolve_move(player_id, expected)
+
+        batch.resolve_moves(action_types, targets, values)
+
+    batch = hb.BatchBoard(num_games, num_players, batch.decks)
+    batch.setup()
+    scores = hb.play_batch(batch, agent)
+    assert list(scores) == [game.score for game in games]
+
@@ -0,0 +1,130 @@
+import argparse
+import multiprocessing
+import os
+import signal
+import pytest
+import main
+from hanasim.checkpoint import Checkpoint
+from hanasim.executors import make_executor
+from hanasim.stats import PairedStats, ScoreStats
+
+CONFIG = {"agents": ["agents.cheat_tobin"], "players": [3], "seed": 0}
+CHUNKS = [(start, start + 10, 3, 0) for start in range(0, 50, 10)]
+
+
+def chunk_stats(chunk):
+    stats = ScoreStats()
+    start, stop, _, _ = chunk
+    for index in range(start, stop):
+        stats.update(index % 26, index % 4, 40 + index)
+    return stats
+
+
+def test_resume(tmp_path):
+    """Test that a reopened checkpoint holds the recorded chunks"""
+
+    path = tmp_path / "run.jsonl"
+    with Checkpoint(path, CONFIG) as checkpoint:
+        assert checkpoint.pending(CHUNKS) == CHUNKS
+        for chunk in CHUNKS[:3]:
+            checkpoint.record(chunk, chunk_stats(chunk))
+
+    with Checkpoint(path, CONFIG) as checkpoint:
+        assert checkpoint.pending(CHUNKS) == CHUNKS[3:]
+        done = checkpoint.done(CHUNKS)
+        assert [chunk for chunk, _ in done] == CHUNKS[:3]
+        for chunk, stats in done:
+            assert stats.to_dict() == chunk_stats(chunk).to_dict()
+        checkpoint.record(CHUNKS[3], [chunk_stats(CHUNKS[3]), PairedStats()])
+
+    with Checkpoint(path, CONFIG) as checkpoint:
+        assert checkpoint.pending(CHUNKS) == CHUNKS[4:]
+        _, (first, second) = checkpoint.done(CHUNKS)[3]
+        assert first.count == 10
+        assert type(second) is PairedStats
+
+
+def test_torn_record(tmp_path):
+    """Test that a record cut off by a crash is dropped and overwritten"""
+
+    path = tmp_path / "run.jsonl"
+    with Checkpoint(path, CONFIG) as checkpoint:
+        for chunk in CHUNKS[:2]:
+            checkpoint.record(chunk, chunk_stats(chunk))
+    data = path.read_bytes()
+    path.write_bytes(data[:-20])
+
+    with Checkpoint(path, CONFIG) as checkpoint:
+        assert checkpoint.pending(CHUNKS) == CHUNKS[1:]
+        checkpoint.record(CHUNKS[1], chunk_stats(CHUNKS[1]))
+
+    with Checkpoint(path, CONFIG) as checkpoint:
+        assert checkpoint.pending(CHUNKS) == CHUNKS[2:]
+    assert path.read_bytes() == data
+
+
+def test_config_mismatch(tmp_path):
+    """Test that a checkpoint is not resumed by a different run"""
+
+    path = tmp_path / "run.jsonl"
+    Checkpoint(path, CONFIG).close()
+
+    with pytest.raises(ValueError):
+        Checkpoint(path, dict(CONFIG, seed=1))
+
+
+def logged_sweep(checkpoint, logs):
+    """Play 50 games in chunks of 10 on the serial executor, logging them"""
+
+    args = argparse.Namespace(
+        games=50,
+        batch=50,
+        precision=None,
+        chunksize=10,
+        players=[3],
+        seed=0,
+        vectorized=False,
+    )
+    initargs = ([CONFIG["agents"][0]], None, 50, None, False, "packed", None, 0, True)
+    with make_executor("serial", main.init_worker, initargs) as executor:
+        return main.run_sweep(executor, args, checkpoint, logs)[0]
+
+
+def killed_sweep(path, log_path, kill_at, logged_first):
+    """Run logged_sweep and SIGKILL it on recording the chunk at kill_at"""
+
+    class KilledCheckpoint(Checkpoint):
+        def record(self, chunk, stats, log_end=None):
+            if chunk[0] == kill_at and logged_first:
+                os.kill(os.getpid(), signal.SIGKILL)
+            super().record(chunk, stats, log_end)
+            if chunk[0] == kill_at:
+                os.kill(os.getpid(), signal.SIGKILL)
+
+    checkpoint = KilledCheckpoint(path, CONFIG)
+    logged_sweep(checkpoint, main.open_logs(log_path, checkpoint))
+
+
+@pytest.mark.parametrize("logged_first", [False, True])
+def test_resume_action_logs(tmp_path, logged_first):
+    """Test that a killed and resumed run logs every game once"""
+
+    with Checkpoint(tmp_path / "full.jsonl", CONFIG) as checkpoint:
+        with main.open_logs(str(tmp_path / "full.log"), checkpoint) as logs:
+            logged_sweep(checkpoint, logs)
+
+    # Killed after writing the logs of games 20 to 30, before or after
+    # recording their chunk
+    path, log_path = tmp_path / "run.jsonl", str(tmp_path / "run.log")
+    killed = multiprocessing.Process(
+        target=killed_sweep, args=(path, log_path, 20, logged_first)
+    )
+    killed.start()
+    killed.join()
+    assert killed.exitcode == -signal.SIGKILL
+
+    with Checkpoint(path, CONFIG) as checkpoint:
+        assert len(checkpoint.pending(CHUNKS)) == (3 if logged_first else 2)
+        with main.open_logs(log_path, checkpoint) as logs:
+            assert logged_sweep(checkpoint, logs).count == 50
+    assert (tmp_path / "run.log").read_bytes() == (tmp_path / "full.log").read_bytes()
@@ -0,0 +1,34 @@
+import pytest
+import numpy as np
+from hanasim import seeding
+from hanasim import corpus as hc
+
+
+def test_corpus_roundtrip(tmp_path):
+    """Test that a corpus holds the decks of a seeded sweep"""
+
+    path = str(tmp_path / "decks.bin")
+    hc.write_corpus(path, 25, seed=4, block=10)
+
+    decks = hc.DeckCorpus(path)
+    assert len(decks) == 25
+    assert decks.seed == 4
+    assert (tmp_path / "decks.bin").stat().st_size == 16 + 25 * 50
+    assert np.array_equal(decks.codes(0, 25), seeding.game_decks(4, 0, 25))
+    assert decks.deck(17) == seeding.game_deck(4, 17)
+
+
+def test_corpus_invalid(tmp_path):
+    """Test that files which are not corpora are rejected"""
+
+    path = tmp_path / "garbage.bin"
+    path.write_bytes(b"not a deck corpus at all")
+    with pytest.raises(ValueError):
+        hc.DeckCorpus(str(path))
+
+    path = str(tmp_path / "decks.bin")
+    hc.write_corpus(path, 2, seed=0)
+    with open(path, "ab") as f:
+        f.write(b"\0" * 7)
+    with pytest.raises(ValueError):
+        hc.DeckCorpus(path)
@@ -0,0 +1,80 @@
+import numpy as np
+import pytest
+from hanasim import hanasim as hs
+from hanasim import corpus as hc
+from hanasim import difficulty as hd
+from hanasim.packed import PackedBoard
+from hanasim.seeding import DECK_CODES
+import agents.cheat_tobin as tobin
+
+
+@pytest.mark.parametrize("num_players", [2, 3, 4, 5])
+def test_difficulty(num_players):
+    """Test that batches of decks are indexed like single decks"""
+
+    decks = np.array(
+        [np.random.default_rng(seed).permutation(DECK_CODES) for seed in range(64)]
+    )
+    records = hd.difficulty(decks, num_players)
+    for deck, record in zip(decks.tolist(), records.tolist()):
+        expected = hd.deck_difficulty(deck, num_players)
+        assert record[:4] == expected[:4]
+        assert record[4] == pytest.approx(expected[4])
+
+
+def test_late_firework():
+    """Test the index of decks ending in a firework in reverse order"""
+
+    codes = [hs.card_code(card) for card in hs.DECK]
+    assert hd.deck_difficulty(codes, 2)[:4] == (25, 1, 1, 1)
+
+    # With the white cards last and W1 drawn after W5, the white firework
+    # needs more plays after the last draw than 2 players have bonus turns
+    white = [code for code in codes if code < len(hs.RANKS)]
+    codes = [code for code in codes if code >= len(hs.RANKS)] + white[::-1]
+    assert hd.deck_difficulty(codes, 2)[:4] == (24, 2, 1, 0)
+    assert hd.deck_difficulty(codes, 3)[0] == 25
+
+
+@pytest.mark.parametrize("num_players", [2, 3, 4, 5])
+def test_bound(num_players):
+    """Test that cheating players never score above the bound"""
+
+    for seed in range(20):
+        deck = hs.shuffled_deck(np.random.default_rng(seed))
+        game = PackedBoard(num_players, deck)
+        players = [tobin.Agent(ii, game) for ii in range(num_players)]
+        for ii, player in enumerate(players):
+            game.set_player(player, ii)
+        game.setup()
+        hs.play_game(game, players)
+
+        codes = [hs.card_code(card) for card in deck]
+        bound = hd.deck_difficulty(codes, num_players)[0]
+        assert game.score <= bound
+
+
+def test_index_roundtrip(tmp_path):
+    """Test that an index holds a record per corpus deck"""
+
+    corpus_path = str(tmp_path / "decks.bin")
+    hc.write_corpus(corpus_path, 30, seed=2)
+    path = hd.write_index(corpus_path, 4, block=8)
+    assert path == hd.index_path(corpus_path, 4)
+
+    corpus = hc.DeckCorpus(corpus_path)
+    index = hd.DeckIndex(path, corpus)
+    assert len(index) == index.num_decks == 30
+    assert index.seed == 2
+    assert index.num_players == 4
+    decks = corpus.codes(0, 30).astype(np.intp)
+    assert np.array_equal(index.records, hd.difficulty(decks, 4))
+
+    with pytest.raises(ValueError):
+        hd.DeckIndex(corpus_path)
+
+    # An index of an older corpus at the same path is rejected
+    for count, seed in [(30, 3), (40, 2)]:
+        hc.write_corpus(corpus_path, count, seed=seed)
+        with pytest.raises(ValueError):
+            hd.DeckIndex(path, hc.DeckCorpus(corpus_path))
@@ -0,0 +1,96 @@
+import random
+import pytest
+from hanasim import hanasim as hs
+from hanasim.endgame import EndgameSolver
+from hanasim.native import BACKENDS
+from hanasim.packed import PackedBoard
+import agents.cheater_discard_first as discard_first
+
+
+def endgame(num_players, seed, board_class=PackedBoard):
+    """Play a shuffled deck with weak cheaters until the deck is empty"""
+
+    deck = list(hs.DECK)
+    random.Random(seed).shuffle(deck)
+    game = board_class(num_players, deck)
+    players = [discard_first.Agent(ii, game) for ii in range(num_players)]
+    game.setup()
+    while game.index < len(game.deck) and not game.game_over:
+        player_id = game.turn % num_players
+        game.resolve_move(player_id, players[player_id].find_move(game))
+    return game
+
+
+def position(game):
+    hands = tuple(
+        tuple(sorted(hs.card_code(game.deck[i]) for i in hand))
+        for hand in game.player_hands
+    )
+    return (
+        hands,
+        tuple(game.fireworks),
+        game.num_hints,
+        game.num_strikes,
+        game.bonus_turns,
+        game.turn % game.num_players,
+    )
+
+
+def brute_force(game, table):
+    """Best final score over every legal move, including misplays and hints"""
+
+    if game.game_over:
+        return game.score
+    key = position(game)
+    if key in table:
+        return table[key]
+
+    player_id = game.turn % game.num_players
+    legal = game.legal_actions(player_id)
+    state = game.snapshot()
+    best = game.score
+    for action in range(game.num_actions):
+        if legal >> action & 1:
+            game.resolve_move(player_id, game.action_to_move(player_id, action))
+            best = max(best, brute_force(game, table))
+            game.restore(state)
+    table[key] = best
+    return best
+
+
+@pytest.mark.parametrize("num_players", [2, 3])
+def test_solve(num_players):
+    """Test that the solver finds the best score of an exhaustive search"""
+
+    solver = EndgameSolver(num_players)
+    for seed in range(3):
+        game = endgame(num_players, seed)
+        if game.game_over:
+            continue
+        assert solver.solve(game) == brute_force(game, {})
+
+
+@pytest.mark.parametrize("board_class", BACKENDS.values())
+def test_best_move(board_class):
+    """Test that playing the best moves reaches the solved score"""
+
+    solver = EndgameSolver(3)
+    for seed in range(4):
+        game = endgame(3, seed, board_class)
+        value = solver.solve(game)
+        assert game.score <= value <= 25
+        while not game.game_over:
+            game.resolve_move(game.turn % 3, solver.best_move(game))
+            assert solver.solve(game) == value
+        assert game.score == value
+
+
+def test_invalid():
+    """Test that games before their endgame are rejected"""
+
+    game = PackedBoard(3, list(hs.DECK))
+    game.setup()
+    with pytest.raises(ValueError):
+        EndgameSolver(3).solve(game)
+    with pytest.raises(ValueError):
+        EndgameSolver(4).solve(endgame(3, 0))
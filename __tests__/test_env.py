@@ -0,0 +1,150 @@
+import numpy as np
+import pytest
+from hanasim import hanasim as hs
+from hanasim.env import AsyncVectorEnv, BatchVectorEnv, VectorEnv
+from hanasim.observation import ObservationEncoder
+from hanasim.seeding import game_deck
+
+
+def random_actions(legal, rng):
+    """One random legal action index per environment"""
+    return np.array([rng.choice(np.flatnonzero(row)) for row in legal])
+
+
+def assert_same_step(first, second):
+    for a, b in zip(first[:4], second[:4]):
+        assert np.array_equal(a, b)
+    for name in ("legal", "player", "final_score"):
+        assert np.array_equal(first[4][name], second[4][name])
+
+
+@pytest.mark.parametrize("num_players", [2, 3, 4, 5])
+def test_batch_env(num_players):
+    """Test that both environments play the same games for the same seed"""
+
+    rng = np.random.default_rng(num_players)
+    env = VectorEnv(8, num_players, seed=3)
+    batch_env = BatchVectorEnv(8, num_players, seed=3)
+
+    observations, info = env.reset()
+    batch_observations, batch_info = batch_env.reset()
+    assert observations.shape == (8, ObservationEncoder(num_players).size)
+    assert np.array_equal(observations, batch_observations)
+    assert np.array_equal(info["legal"], batch_info["legal"])
+
+    finished = 0
+    for _ in range(300):
+        actions = random_actions(info["legal"], rng)
+        result = env.step(actions)
+        assert_same_step(result, batch_env.step(actions))
+        info = result[4]
+        finished += result[2].sum()
+
+    assert finished > 0
+    assert np.array_equal(env.episodes, batch_env.episodes)
+
+
+def test_auto_reset():
+    """Test rewards, final scores and the reset of finished games"""
+
+    rng = np.random.default_rng(0)
+    env = VectorEnv(4, 3, seed=1)
+    _, info = env.reset()
+    scores = np.zeros(4)
+
+    for _ in range(400):
+        actions = random_actions(info["legal"], rng)
+        _, rewards, terminated, truncated, info = env.step(actions)
+        assert not truncated.any()
+        scores += rewards
+        for env_index in np.flatnonzero(terminated):
+            assert info["final_score"][env_index] == scores[env_index]
+            assert info["player"][env_index] == 0
+            assert env.games[env_index].turn == 0
+            scores[env_index] = 0
+        assert np.all(info["final_score"][~terminated] == 0)
+
+    # Game k of environment i is dealt deck i + k * num_envs
+    assert np.all(env.episodes > 1)
+    for env_index, game in enumerate(env.games):
+        index = env_index + (int(env.episodes[env_index]) - 1) * 4
+        assert game.deck == game_deck(1, index)
+
+
+@pytest.mark.parametrize("env_class", [VectorEnv, BatchVectorEnv])
+def test_illegal_action(env_class):
+    """Test that actions outside the action space or illegal are rejected"""
+
+    env = env_class(2, 2)
+    env.reset()
+    with pytest.raises(ValueError):
+        env.step(np.array([-1, 0]))
+    with pytest.raises(ValueError):
+        env.step(np.array([env.num_actions, 0]))
+
+    # Hints are illegal without hint tokens
+    hint = hs.ACTION_INDEX[2][hs.HINTCOLOUR, 1, 0]
+    discard = hs.ACTION_INDEX[2][hs.DISCARD, 0, 0]
+    for _ in range(hs.Board.MAXHINTS):
+        env.step(np.array([hint, discard]))
+    assert not env.legal[0, hint]
+    with pytest.raises(ValueError):
+        env.step(np.array([hint, discard]))
+
+
+@pytest.mark.parametrize("env_class", [VectorEnv, BatchVectorEnv])
+def test_illegal_last_action(env_class):
+    """Test that an illegal action leaves every environment unstepped"""
+
+    env, reference = env_class(3, 2, seed=4), env_class(3, 2, seed=4)
+    _, info = env.reset()
+    reference.reset()
+    actions = random_actions(info["legal"], np.random.default_rng(4))
+    observations = env.observations.copy()
+
+    illegal = actions.copy()
+    illegal[-1] = env.num_actions
+    with pytest.raises(ValueError):
+        env.step(illegal)
+    assert np.array_equal(env.observations, observations)
+    assert_same_step(env.step(actions), reference.step(actions))
+
+
+@pytest.mark.parametrize("env_class", [VectorEnv, BatchVectorEnv])
+def test_async_illegal_action(env_class):
+    """Test that an illegal action is rejected before any worker steps"""
+
+    reference = env_class(3, 2, seed=4)
+    reference.reset()
+    with AsyncVectorEnv(3, 2, num_workers=3, seed=4, env_class=env_class) as env:
+        _, info = env.reset()
+        actions = random_actions(info["legal"], np.random.default_rng(4))
+        observations = env.buffers["observations"].copy()
+
+        illegal = actions.copy()
+        illegal[-1] = info["legal"].shape[1]
+        with pytest.raises(ValueError):
+            env.step(illegal)
+        assert np.array_equal(env.buffers["observations"], observations)
+        assert_same_step(env.step(actions), reference.step(actions))
+
+
+@pytest.mark.parametrize("env_class", [VectorEnv, BatchVectorEnv])
+def test_async_env(env_class):
+    """Test that workers on shared buffers step like a single environment"""
+
+    rng = np.random.default_rng(5)
+    env = env_class(6, 3, seed=2)
+    _, info = env.reset()
+
+    with AsyncVectorEnv(6, 3, num_workers=3, seed=2, env_class=env_class) as async_env:
+        observations, async_info = async_env.reset()
+        assert np.array_equal(observations, env.observations)
+        assert np.array_equal(async_info["legal"], info["legal"])
+
+        for _ in range(100):
+            actions = random_actions(info["legal"], rng)
+            async_env.step_async(actions)
+            result = env.step(actions)
+            assert_same_step(result, async_env.step_wait())
+            info = result[4]
@@ -0,0 +1,75 @@
+import multiprocessing
+import pytest
+from hanasim import executors as he
+
+AUTHKEY = b"test"
+
+# Worker state set by the initializer
+scale = None
+setups = 0
+
+
+def init(factor):
+    global scale, setups
+    scale = factor
+    setups += 1
+
+
+def task(value):
+    if value < 0:
+        raise ValueError("negative task")
+    return value * scale
+
+
+def socket_executor(processes):
+    executor = he.SocketExecutor(init, (3,), processes=processes, authkey=AUTHKEY)
+    for _ in range(processes):
+        multiprocessing.Process(
+            target=he.serve, args=(executor.address, AUTHKEY), daemon=True
+        ).start()
+    return executor
+
+
+@pytest.mark.parametrize("name", ["serial", "local", "socket"])
+def test_executors(name):
+    """Test that every executor sets up its workers and plays all tasks"""
+
+    if name == "socket":
+        executor = socket_executor(3)
+    else:
+        executor = he.make_executor(name, init, (3,), processes=2)
+
+    with executor:
+        assert sorted(executor.imap_unordered(task, range(20))) == [
+            3 * value for value in range(20)
+        ]
+        # Workers stay set up between maps
+        assert sorted(executor.imap_unordered(task, [5, 7])) == [15, 21]
+
+
+def test_socket_task_error():
+    """Test that a failed task is raised in the driver"""
+
+    with socket_executor(1) as executor:
+        with pytest.raises(RuntimeError, match="negative task"):
+            list(executor.imap_unordered(task, [1, -1, 2]))
+
+
+def test_initialized_call():
+    """Test that the initializer runs once per executor setup"""
+
+    before = setups
+    first = ("a", init, (2,))
+    assert he.initialized_call(first, task, 4) == 8
+    assert he.initialized_call(first, task, 5) == 10
+    assert setups == before + 1
+    assert he.initialized_call(("b", init, (5,)), task, 1) == 5
+    assert setups == before + 2
+
+
+def test_make_executor():
+    assert he.parse_address("node7:5000") == ("node7", 5000)
+    with pytest.raises(ValueError):
+        he.parse_address("5000")
+    with pytest.raises(ValueError):
+        he.make_executor("mpi")
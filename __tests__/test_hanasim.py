@@ -1,11 +1,18 @@
 import pytest
 import random
 from hanasim import hanasim as hs
+from hanasim.native import BACKENDS
 from unittest.mock import Mock, patch, call
 
 
+@pytest.fixture(params=list(BACKENDS))
+def board_class(request):
+    """Every Board implementation, the tests run against all of them"""
+    return BACKENDS[request.param]
+
+
 @pytest.fixture()
-def game():
+def game(board_class):
     """Setup a game of 5-player hanabi with a pre-defined deck"""
 
     # Create deck with cards in known order
@@ -14,7 +21,7 @@ def game():
         deck.append(hs.Card(0, 1))
 
     num_players = 3
-    game = hs.Board(num_players, deck)
+    game = board_class(num_players, deck)
     for i in range(num_players):
         game.set_player(Mock(), i)
 
@@ -22,13 +29,18 @@ def game():
     return game
 
 
+def hand_card(game, player_id, slot):
+    """Card in a hand slot, as tracked by the board"""
+    return game.deck[game.player_hands[player_id][slot]]
+
+
 @pytest.mark.parametrize("num_players", [2, 3, 4, 5])
-def test_init_random_deck(num_players):
+def test_init_random_deck(board_class, num_players):
     """Test that game initializes correctly for a random deck"""
 
     hand_size = {2: 5, 3: 5, 4: 4, 5: 4}
 
-    game = hs.Board(num_players)
+    game = board_class(num_players)
     for i in range(num_players):
         game.set_player(Mock(), i)
     game.setup()
@@ -75,7 +87,7 @@ def test_play_success(game):
     for colour in range(num_players):
         for rank in hs.RANKS:
             card = game.deck[colour * len(hs.RANKS) + rank-1]
-            game.players[colour].remove.return_value = card
+            assert hand_card(game, colour, 0) == card
             action = (hs.PLAY, 0, colour)
             game.resolve_move(colour, action)
 
@@ -95,9 +107,9 @@ def test_play_success(game):
 def test_play_fail(game):
     """Test that a strike is issued when playing an illegal card"""
 
-    # Setup mock
+    # Check the card in the hand slot
     player_id = 0
-    game.players[player_id].remove.return_value = hs.Card(0,2)
+    assert hand_card(game, player_id, 1) == hs.Card(0,2)
 
     # Play illegal card
     game.num_hints = 0
@@ -114,9 +126,9 @@ def test_play_fail(game):
 def test_discard(game):
     """Test discard method"""
 
-    # Setup mock
+    # Check the card in the hand slot
     player_id = 0
-    game.players[player_id].remove.return_value = hs.Card(0,1)
+    assert hand_card(game, player_id, 0) == hs.Card(0,1)
 
     # Discard a card
     game.num_hints = 0
@@ -132,9 +144,9 @@ def test_discard(game):
 def test_discard_maxhints(game):
     """Test that no hint is given at maximum number of hints"""
 
-    # Setup mock discard behaviour
+    # Check the card in the hand slot
     player_id = 0
-    game.players[player_id].remove.return_value = game.deck[0]
+    assert hand_card(game, player_id, 0) == game.deck[0]
 
     action = (hs.DISCARD, 0, None)
     game.resolve_move(0, action)
@@ -171,26 +183,26 @@ def test_critical_cards_discard(game):
       remains
     """
 
-    game.players[0].remove.return_value = hs.Card(0,2)
+    assert hand_card(game, 0, 1) == hs.Card(0,2)
     action = (hs.DISCARD, 1, None)
     game.resolve_move(0, action)
     assert (0, 2) in game.critical_cards
 
-    game.players[0].remove.return_value = hs.Card(0,5)
+    assert hand_card(game, 0, 3) == hs.Card(0,5)
     action = (hs.DISCARD, 3, None)
     game.resolve_move(0, action)
     assert (0, 5) in game.dead_cards
     assert (0, 5) not in game.critical_cards
 
     for rank in hs.RANKS:
-        game.players[1].remove.return_value = hs.Card(1, rank)
+        assert hand_card(game, 1, 0) == hs.Card(1, rank)
         action = (hs.PLAY, 0, 1)
         game.resolve_move(1, action)
 
     assert (1, 5) not in game.critical_cards
 
 
-def test_dead_cards():
+def test_dead_cards(board_class):
     """Test critical cards
     - Verify that cards are added to dead card set when smaller cards are dead
     """
@@ -203,14 +215,14 @@ def test_dead_cards():
     ]
 
     num_players = 3
-    game = hs.Board(num_players, deck)
+    game = board_class(num_players, deck)
     for i in range(num_players):
         game.set_player(Mock(), i)
     game.setup()
 
     action = (hs.DISCARD, 0, 0)
     for _ in range(3):
-        game.players[0].remove.return_value = hs.Card(0,1)
+        assert hand_card(game, 0, 0) == hs.Card(0,1)
         game.resolve_move(0, action)
 
     for rank in hs.RANKS:
@@ -222,8 +234,8 @@ def test_critical_cards_play(game):
     - Verify that cards are removed when played
     """
 
-    for _ in hs.RANKS:
-        game.players[0].remove.return_value = hs.Card(0,2)
+    for rank in hs.RANKS:
+        assert hand_card(game, 0, 0) == hs.Card(0, rank)
         action = (hs.DISCARD, 0, 1)
         game.resolve_move(0, action)
 
@@ -236,7 +248,273 @@ def test_playable_cards(game):
     for colour in hs.COLOURS:
         assert (colour, 1) in game.playable_cards
 
-    game.players[0].remove.return_value = hs.Card(0,1)
+    assert hand_card(game, 0, 0) == hs.Card(0,1)
     action = (hs.PLAY, 0, 0)
     game.resolve_move(0, action)
     assert (0, 2) in game.playable_cards
+
+
+def test_card_queries(game):
+    """Test is_playable, is_useless, is_critical and is_dead queries"""
+
+    assert game.is_playable(hs.Card(0, 1))
+    assert not game.is_playable(hs.Card(0, 2))
+    assert game.is_critical(hs.Card(0, 5))
+    assert not game.is_useless(hs.Card(0, 1))
+
+    assert hand_card(game, 0, 0) == hs.Card(0, 1)
+    game.resolve_move(0, (hs.PLAY, 0, 0))
+
+    assert not game.is_playable(hs.Card(0, 1))
+    assert game.is_playable(hs.Card(0, 2))
+    assert game.is_useless(hs.Card(0, 1))
+    assert not game.is_dead(hs.Card(0, 1))
+    assert hs.Card(0, 1) in game.useless_cards
+
+
+def test_misplay_last_copy(game):
+    """Test that misplaying the last copy of a card kills it"""
+
+    assert hand_card(game, 0, 4) == hs.Card(0, 5)
+    game.resolve_move(0, (hs.PLAY, 4, 0))
+
+    assert game.num_strikes == 1
+    assert game.is_dead(hs.Card(0, 5))
+    assert game.is_useless(hs.Card(0, 5))
+    assert not game.is_critical(hs.Card(0, 5))
+    assert game.max_score == 24
+    assert game.total_discarded == 0
+
+
+def test_discard_played_copies(board_class):
+    """Test that discarding copies of a played card does not kill it"""
+
+    game = board_class(2, [hs.Card(0, 1)] * 50)
+    game.setup()
+    game.resolve_move(0, (hs.PLAY, 0, 0))
+    for _ in range(2):
+        game.resolve_move(0, (hs.DISCARD, 0, None))
+
+    assert game.discard_pile[hs.Card(0, 1)] == 2
+    assert not game.is_critical(hs.Card(0, 1))
+    assert not game.dead_cards
+    assert game.max_score == 25
+
+
+def test_pace(game):
+    """Test pace after dealing and after a card dies"""
+
+    # 35 cards left in deck for 3 players
+    assert game.pace == 35 + 3 - 25
+
+    assert hand_card(game, 0, 4) == hs.Card(0, 5)
+    game.resolve_move(0, (hs.DISCARD, 4, None))
+    assert game.pace == 34 + 3 - 24
+
+
+def test_player_hands(game):
+    """Test that the board deals hands of deck indices"""
+
+    assert game.player_hands == [[0, 1, 2, 3, 4], [5, 6, 7, 8, 9], [10, 11, 12, 13, 14]]
+
+    game.resolve_move(0, (hs.DISCARD, 1, None))
+    assert game.player_hands[0] == [0, 2, 3, 4, 15]
+    game.players[0].remove.assert_called_with(1)
+    game.players[0].draw.assert_called_with(game.deck[15])
+
+
+def test_get_hand(game):
+    """Test that players see other hands but not their own"""
+
+    hand = game.get_hand(1, 0)
+    assert list(hand) == [hs.Card(1, rank) for rank in hs.RANKS]
+    assert hand[2] == hs.Card(1, 3)
+
+    with pytest.raises(ValueError):
+        game.get_hand(1, 1)
+
+    # The view follows changes to the hand
+    game.resolve_move(1, (hs.PLAY, 0, 1))
+    assert hand[0] == hs.Card(1, 2)
+    assert len(hand) == 5
+
+
+def test_visible_count(game):
+    """Test the multiset of cards each player sees in other hands"""
+
+    assert game.visible_count(0, hs.Card(1, 1)) == 1
+    assert game.visible_count(1, hs.Card(1, 1)) == 0
+    assert game.visible_count(0, hs.Card(0, 1)) == 0
+    assert game.visible_count(2, hs.Card(0, 1)) == 1
+
+    # Player 1 plays its one and draws a blue one
+    game.resolve_move(1, (hs.PLAY, 0, 1))
+    assert game.visible_count(0, hs.Card(1, 1)) == 0
+    assert game.visible_count(0, hs.Card(3, 1)) == 1
+    assert game.visible_count(1, hs.Card(3, 1)) == 0
+
+
+def test_legal_actions(game):
+    """Test the legal action mask over the fixed action space"""
+
+    # 5 plays, 5 discards and 2 targets with 5 colour and 5 rank hints each
+    assert game.num_actions == 5 + 5 + 2 * 5 + 2 * 5
+    assert game.legal_actions(0) == (1 << game.num_actions) - 1
+
+    game.num_hints = 0
+    assert game.legal_actions(0) == (1 << 10) - 1
+    assert game.is_legal(0, 9)
+    assert not game.is_legal(0, 10)
+
+    # A short hand at the end of the game only plays and discards its cards
+    game.num_hints = 1
+    game.index = 50
+    game.resolve_move(0, (hs.DISCARD, 0, None))
+    mask = game.legal_actions(0)
+    assert not game.is_legal(0, 4) and not game.is_legal(0, 9)
+    assert game.is_legal(0, 3) and game.is_legal(0, 8)
+    assert mask >> 10 == (1 << 20) - 1
+
+
+def test_action_moves(game):
+    """Test the mapping between action indices and moves"""
+
+    assert game.action_to_move(0, 0) == (hs.PLAY, 0, hs.WHITE)
+    assert game.action_to_move(1, 2) == (hs.PLAY, 2, hs.YELLOW)
+    assert game.action_to_move(0, 7) == (hs.DISCARD, 2, 0)
+    assert game.action_to_move(2, 10) == (hs.HINTCOLOUR, 0, hs.WHITE)
+    assert game.action_to_move(2, 29) == (hs.HINTRANK, 1, hs.FIVE)
+
+    for player_id in range(game.num_players):
+        for index in range(game.num_actions):
+            move = game.action_to_move(player_id, index)
+            assert game.move_to_action(player_id, move) == index
+
+
+@pytest.mark.parametrize(
+    "action",
+    [
+        (hs.PLAY, 5, 0),
+        (hs.PLAY, 0, -1),
+        (hs.PLAY, 0, 8),
+        (hs.DISCARD, -1, 0),
+        (hs.HINTCOLOUR, 0, 0),
+        (hs.HINTRANK, 3, 1),
+        (hs.HINTRANK, 1, 0),
+        (hs.HINTCOLOUR, 1, 5),
+        (hs.ENDGAME, 0, 0),
+    ],
+)
+@pytest.mark.parametrize("num_hints", [8, 3])
+def test_illegal_moves(game, action, num_hints):
+    """Test that illegal moves raise ValueError and leave the game unchanged"""
+
+    game.num_hints = num_hints
+    hands = [list(hand) for hand in game.player_hands]
+    with pytest.raises(ValueError):
+        game.resolve_move(0, action)
+
+    assert game.turn == 0
+    assert game.num_hints == num_hints
+    assert game.num_strikes == 0
+    assert [list(hand) for hand in game.player_hands] == hands
+    assert len(game.action_log) == 0
+
+
+def test_hint_without_tokens(game):
+    """Test that hints need a hint token"""
+
+    game.num_hints = 0
+    with pytest.raises(ValueError):
+        game.resolve_move(0, (hs.HINTCOLOUR, 1, 0))
+
+
+def test_hint_knowledge(game):
+    """Test the possibility masks and hint bits of hinted hand slots"""
+
+    # Player 2 holds green 1 to 5
+    assert game.slot_masks[2] == [hs.ALL_CARDS_MASK] * 5
+    game.resolve_move(0, (hs.HINTRANK, 2, 3))
+    assert game.possible_cards(2, 2) == [hs.Card(c, 3) for c in hs.COLOURS]
+    assert hs.Card(hs.GREEN, 3) not in game.possible_cards(2, 0)
+    assert len(game.possible_cards(2, 0)) == 20
+
+    game.resolve_move(1, (hs.HINTCOLOUR, 2, hs.GREEN))
+    assert game.possible_cards(2, 2) == [hs.Card(hs.GREEN, 3)]
+    assert game.possible_cards(2, 4) == [hs.Card(hs.GREEN, r) for r in (1, 2, 4, 5)]
+    green = 1 << hs.POSITIVE_COLOUR + hs.GREEN
+    assert game.hint_bits[2][2] == green | 1 << hs.POSITIVE_RANK + 2
+    assert game.hint_bits[2][0] == green | 1 << hs.NEGATIVE_RANK + 2
+
+    # Knowledge moves with the cards and a drawn card is unknown
+    game.resolve_move(2, (hs.PLAY, 0, hs.GREEN))
+    assert game.possible_cards(2, 1) == [hs.Card(hs.GREEN, 3)]
+    assert game.slot_masks[2][4] == hs.ALL_CARDS_MASK
+    assert game.hint_bits[2][4] == 0
+    assert len(game.slot_masks[2]) == len(game.player_hands[2])
+
+
+def test_hint_knowledge_is_consistent(board_class):
+    """Test that every hand card stays possible in its slot"""
+
+    rng = random.Random(0)
+    game = board_class(4)
+    game.setup()
+    while not game.game_over:
+        player_id = game.turn % 4
+        if game.num_hints and rng.random() < 0.5:
+            target = (player_id + rng.randrange(1, 4)) % 4
+            hint_type = rng.choice([hs.HINTCOLOUR, hs.HINTRANK])
+            value = rng.choice(hs.COLOURS if hint_type == hs.HINTCOLOUR else hs.RANKS)
+            game.resolve_move(player_id, (hint_type, target, value))
+        else:
+            game.resolve_move(player_id, (hs.DISCARD, 0, None))
+
+        for hand, masks in zip(game.player_hands, game.slot_masks):
+            assert len(hand) == len(masks)
+            for position, mask in zip(hand, masks):
+                assert mask >> hs.card_code(game.deck[position]) & 1
+
+
+def test_event_subscriptions(board_class):
+    """Test that players only receive the events they subscribe to"""
+
+    class HintListener:
+        EVENTS = frozenset([hs.COLOUR_HINT])
+
+        def __init__(self):
+            self.hints = []
+
+        def receive_colour_hint(self, colour):
+            self.hints.append(colour)
+
+    game = board_class(2)
+    listener, mock = HintListener(), Mock()
+    game.set_player(listener, 0)
+    game.set_player(mock, 1)
+    game.setup()
+
+    game.resolve_move(1, (hs.HINTCOLOUR, 0, hs.RED))
+    game.resolve_move(0, (hs.DISCARD, 0, None))
+    game.resolve_move(1, (hs.HINTCOLOUR, 0, hs.BLUE))
+    assert listener.hints == [hs.RED, hs.BLUE]
+    assert game.listeners[hs.DRAW][0] is None
+    assert mock.draw.call_count == 5
+
+    # Detached players receive nothing
+    game.set_player(None, 1)
+    game.resolve_move(0, (hs.HINTRANK, 1, 1))
+    mock.receive_rank_hint.assert_not_called()
+
+
+def test_events_since(game):
+    """Test pulling the moves made since a player's last turn"""
+
+    game.resolve_move(0, (hs.DISCARD, 0, None))
+    position = len(game.action_log)
+    game.resolve_move(1, (hs.HINTCOLOUR, 0, hs.WHITE))
+    game.resolve_move(2, (hs.PLAY, 0, hs.GREEN))
+
+    events = [hs.decode_action(record) for record in game.events_since(position)]
+    assert [event[0] for event in events] == [hs.HINTCOLOUR, hs.PLAY]
+    assert events[0][1:4] == (1, 0, hs.WHITE)
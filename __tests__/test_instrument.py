@@ -0,0 +1,57 @@
+from hanasim import hanasim as hs
+from hanasim import instrument as hi
+from hanasim.packed import PackedBoard
+from hanasim.seeding import game_deck
+import agents.cheat_tobin as tobin
+
+
+def play(board_class, counters, deck):
+    game = board_class(4, deck)
+    game.setup()
+    players = [hi.TimedAgent(tobin.Agent(i, game), counters) for i in range(4)]
+    return hs.play_game(game, players)
+
+
+def test_instrumented_game():
+    """Test that every phase of a game is counted"""
+
+    counters = hi.Counters()
+    board_class = hi.instrument(PackedBoard, counters)
+    game = play(board_class, counters, game_deck(0, 0))
+
+    assert isinstance(game, PackedBoard)
+    assert counters.calls["find_move"] == game.turn
+    moves = sum(counters.calls.get(phase, 0) for phase in hi.ACTION_PHASES.values())
+    assert moves == game.turn
+    assert counters.calls["draw"] >= 16
+    assert all(seconds >= 0 for seconds in counters.seconds.values())
+
+    # Instrumentation does not change the outcome
+    reference = PackedBoard(4, game_deck(0, 0))
+    reference.setup()
+    hs.play_game(reference, [tobin.Agent(i, reference) for i in range(4)])
+    assert reference.score == game.score
+    assert list(reference.action_log) == list(game.action_log)
+
+
+def test_generate_deck():
+    """Test that deck generation is timed"""
+
+    counters = hi.Counters()
+    game = hi.instrument(hs.Board, counters)(2)
+    game.generate_deck()
+    assert counters.calls == {"generate_deck": 1}
+
+
+def test_merge():
+    """Test merging counters of several workers"""
+
+    first, second = hi.Counters(), hi.Counters()
+    first.add("draw", 1.0)
+    second.add("draw", 0.5, calls=2)
+    second.add("find_move", 0.25)
+
+    merged = hi.Counters().merge(first).merge(second)
+    assert merged.calls == {"draw": 3, "find_move": 1}
+    assert merged.seconds == {"draw": 1.5, "find_move": 0.25}
+    assert "find_move" in merged.summary()
@@ -0,0 +1,73 @@
+import tracemalloc
+from hanasim import hanasim as hs
+from hanasim import memory as hm
+from hanasim.packed import PackedBoard
+from hanasim.seeding import game_deck
+import agents.cheat_tobin as tobin
+
+
+def table(counters, num_players=4):
+    game = hm.track(PackedBoard, counters)(num_players)
+    players = [
+        hm.TrackedAgent(tobin.Agent(i, game), counters, "tobin")
+        for i in range(num_players)
+    ]
+
+    def play(deck):
+        game.reset(deck)
+        game.setup()
+        for player in players:
+            player.reset(game)
+        return hs.play_game(game, players)
+
+    return play
+
+
+def test_traced_game():
+    """Test that the phases of traced games are counted, and only those"""
+
+    counters = hm.MemoryCounters()
+    play = table(counters)
+    play(game_deck(0, 0))
+    assert counters.calls == {}
+
+    game = hm.traced(counters, play, game_deck(0, 1))
+    assert not tracemalloc.is_tracing()
+    assert counters.games == 1
+    assert counters.turns == game.turn
+    assert counters.calls["resolve_move"] == game.turn
+    assert counters.calls["find_move:tobin"] == game.turn
+    assert counters.calls["reset"] == counters.calls["setup"] == 1
+    assert all(size >= 0 for size in counters.allocated.values())
+    assert counters.over_budget(0) == sorted(
+        phase for phase, size in counters.allocated.items() if size > 0
+    )
+    assert counters.over_budget(float("inf")) == []
+
+    # Tracking does not change the outcome
+    reference = PackedBoard(4, game_deck(0, 1))
+    reference.setup()
+    hs.play_game(reference, [tobin.Agent(i, reference) for i in range(4)])
+    assert list(reference.action_log) == list(game.action_log)
+
+
+def test_merge():
+    """Test merging counters and RSS samples of several workers"""
+
+    first, second = hm.MemoryCounters(), hm.MemoryCounters()
+    first.add("resolve_move", 100, 10)
+    second.add("resolve_move", 50, 0)
+    second.add("reset", 8, 8)
+    second.sample_rss(0)
+    second.sample_rss(10)
+
+    merged = hm.MemoryCounters().merge(first).merge(second)
+    assert merged.calls == {"resolve_move": 2, "reset": 1}
+    assert merged.allocated == {"resolve_move": 150, "reset": 8}
+    assert merged.retained == {"resolve_move": 10, "reset": 8}
+    assert sum(len(samples) for samples in merged.rss.values()) == 2
+    assert all(rss > 0 for samples in merged.rss.values() for _, rss in samples)
+    assert "resolve_move" in merged.summary()
+
+    merged.clear()
+    assert merged.calls == {} and merged.rss == {}
@@ -0,0 +1,107 @@
+import random
+import numpy as np
+import pytest
+from hanasim import hanasim as hs
+from hanasim import batch as hb
+from hanasim.native import BACKENDS
+from hanasim.observation import ObservationEncoder
+from hanasim.packed import PackedBoard
+
+
+@pytest.mark.parametrize("num_players", [2, 3, 4, 5])
+def test_layout(num_players):
+    """Test that the sections tile the observation"""
+
+    encoder = ObservationEncoder(num_players)
+    handsize = hs.HANDSIZE[num_players]
+    sections = list(encoder.sections.values())
+
+    assert sections[0].start == 0
+    assert all(a.stop == b.start for a, b in zip(sections, sections[1:]))
+    assert sections[-1].stop == encoder.size
+    assert encoder.size == 25 + 8 + 3 + 50 + (2 * num_players - 1) * handsize * 25
+
+
+@pytest.mark.parametrize("board_class", BACKENDS.values())
+def test_encode(board_class):
+    """Test the features of a game in progress"""
+
+    game = board_class(3, list(hs.DECK))
+    game.setup()
+    game.resolve_move(0, (hs.DISCARD, 4, 0))
+    game.resolve_move(1, (hs.HINTRANK, 2, 1))
+    game.resolve_move(2, (hs.PLAY, 0, 1))
+
+    encoder = ObservationEncoder(3)
+    out = np.zeros((2, encoder.size), dtype=np.float32)
+    observation = encoder.encode(game, 0, out[1])
+    assert observation.base is out
+    sections = {name: out[1, s] for name, s in encoder.sections.items()}
+
+    assert list(np.flatnonzero(sections["fireworks"])) == [5]
+    assert sections["hints"].sum() == 7
+    assert sections["strikes"].sum() == 0
+    discarded = hs.card_code(hs.DECK[4])
+    units = np.flatnonzero(sections["discards"])
+    assert len(units) == 1
+    assert units[0] == sum(hs.CARDCOUNTS[card] for card in hs.CARDS[:discarded])
+
+    hands = sections["hands"].reshape(2, 5, 25)
+    for row, player_id in enumerate([1, 2]):
+        for slot, position in enumerate(game.player_hands[player_id]):
+            code = hs.card_code(game.deck[position])
+            assert list(np.flatnonzero(hands[row, slot])) == [code]
+
+    knowledge = sections["knowledge"].reshape(3, 5, 25)
+    for row in range(3):
+        for slot, mask in enumerate(game.slot_masks[row]):
+            bits = [code for code in range(25) if mask >> code & 1]
+            assert list(np.flatnonzero(knowledge[row, slot])) == bits
+    assert knowledge[2].sum() < 5 * 25
+
+
+def random_move(game, player_id, rng):
+    """Pick a random legal move, hinting half of the time"""
+
+    hand = game.player_hands[player_id]
+    target = rng.randrange(len(hand))
+    if game.num_hints and rng.random() < 0.5:
+        other = (player_id + rng.randrange(1, game.num_players)) % game.num_players
+        if rng.random() < 0.5:
+            return (hs.HINTCOLOUR, other, rng.choice(hs.COLOURS))
+        return (hs.HINTRANK, other, rng.choice(hs.RANKS))
+    if rng.random() < 0.5:
+        return (hs.PLAY, target, game.deck[hand[target]].colour)
+    return (hs.DISCARD, target, 0)
+
+
+@pytest.mark.parametrize("num_players", [2, 3, 4, 5])
+def test_encode_batch(num_players):
+    """Test that batch observations equal those of individual boards"""
+
+    num_games = 16
+    rng = random.Random(num_players)
+    batch = hb.BatchBoard(num_games, num_players)
+    batch.generate_decks(np.random.default_rng(num_players))
+    batch.setup()
+    games = []
+    for deck in batch.decks:
+        game = PackedBoard(num_players, [hs.CARDS[code] for code in deck])
+        game.setup()
+        games.append(game)
+
+    encoder = ObservationEncoder(num_players)
+    out = np.zeros((num_games, encoder.size), dtype=np.uint8)
+    while not batch.game_over.all():
+        observers = np.array([rng.randrange(num_players) for _ in games])
+        encoder.encode_batch(batch, observers, out)
+        for n, game in enumerate(games):
+            assert np.array_equal(out[n], encoder.encode(game, observers[n]))
+
+        moves = np.zeros((3, num_games), dtype=int)
+        for n, game in enumerate(games):
+            if not game.game_over:
+                player_id = game.turn % num_players
+                moves[:, n] = random_move(game, player_id, rng)
+                game.resolve_move(player_id, tuple(moves[:, n].tolist()))
+        batch.resolve_moves(*moves)
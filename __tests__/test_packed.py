@@ -0,0 +1,179 @@
+import pytest
+import random
+from hanasim import hanasim as hs
+from hanasim import packed
+from hanasim.native import NativeBoard
+
+COMPACT_BOARDS = [packed.PackedBoard, NativeBoard]
+
+
+def random_move(game, player_id, rng):
+    """Pick a random move, biased towards playing and discarding"""
+
+    hand = game.get_hand(player_id, (player_id + 1) % game.num_players)
+    target = rng.randrange(len(hand))
+    choice = rng.random()
+    if choice < 0.4:
+        return (hs.PLAY, target, hand[target].colour)
+    if choice < 0.6:
+        return (hs.PLAY, target, rng.choice(hs.COLOURS))
+    if choice < 0.9 or game.num_hints == 0:
+        return (hs.DISCARD, target, None)
+    other = (player_id + 1) % game.num_players
+    return (hs.HINTCOLOUR, other, rng.choice(hs.COLOURS))
+
+
+def new_game(board_class, num_players, deck):
+    game = board_class(num_players, list(deck))
+    game.setup()
+    return game
+
+
+def test_card_code():
+    """Test that card codes enumerate all cards"""
+
+    codes = [hs.card_code(card) for card in hs.CARDS]
+    assert codes == list(range(hs.NUM_CARD_TYPES))
+    assert hs.card_code(hs.Card(hs.RED, hs.FIVE)) == 24
+
+
+def test_card_set():
+    """Test CardSet behaves like a set of cards"""
+
+    cards = packed.CardSet._from_iterable([hs.Card(0, 1), hs.Card(4, 5)])
+    assert hs.Card(0, 1) in cards
+    assert (4, 5) in cards
+    assert (0, 2) not in cards
+    assert len(cards) == 2
+    assert set(cards) == {hs.Card(0, 1), hs.Card(4, 5)}
+    assert cards == {hs.Card(0, 1), hs.Card(4, 5)}
+
+
+def test_setup_critical():
+    """Test that all fives are critical at the start of the game"""
+
+    game = packed.PackedBoard(3)
+    game.setup()
+    assert set(game.critical_cards) == {hs.Card(c, hs.FIVE) for c in hs.COLOURS}
+    assert set(game.playable_cards) == {hs.Card(c, hs.ONE) for c in hs.COLOURS}
+    assert sum(game.discard_pile.values()) == 0
+
+
+def test_playable_after_five():
+    """Test a completed firework has no playable card"""
+
+    deck = [card for card in hs.CARDS] + [hs.Card(0, 1)] * 25
+    game = new_game(packed.PackedBoard, 2, deck)
+    for _ in hs.RANKS:
+        game.resolve_move(0, (hs.PLAY, 0, hs.WHITE))
+
+    assert game.fireworks[hs.WHITE] == hs.FIVE
+    assert not any(card.colour == hs.WHITE for card in game.playable_cards)
+    assert (hs.YELLOW, hs.ONE) in game.playable_cards
+
+
+@pytest.mark.parametrize("board_class", COMPACT_BOARDS)
+@pytest.mark.parametrize("seed", range(20))
+@pytest.mark.parametrize("num_players", [2, 3, 4, 5])
+def test_matches_board(seed, num_players, board_class):
+    """Test that the compact boards play out exactly like Board"""
+
+    rng = random.Random(seed)
+    reference = hs.Board(num_players)
+    reference.generate_deck()
+    deck = reference.deck
+
+    game = new_game(hs.Board, num_players, deck)
+    compact = new_game(board_class, num_players, deck)
+
+    while not game.game_over:
+        player_id = game.turn % num_players
+        action = random_move(game, player_id, rng)
+        game.resolve_move(player_id, action)
+        compact.resolve_move(player_id, action)
+
+        assert compact.game_over == game.game_over
+        assert compact.score == game.score
+        assert compact.num_hints == game.num_hints
+        assert compact.num_strikes == game.num_strikes
+        assert compact.fireworks == game.fireworks
+        assert dict(compact.discard_pile) == game.discard_pile
+        assert set(compact.played_cards) == game.played_cards
+        assert set(compact.dead_cards) == game.dead_cards
+        assert set(compact.useless_cards) == game.useless_cards
+        assert set(compact.critical_cards) == game.critical_cards
+        assert set(compact.playable_cards) == game.playable_cards
+        assert compact.max_score == game.max_score
+        assert compact.pace == game.pace
+        assert list(compact.action_log) == list(game.action_log)
+
+        for card in hs.CARDS:
+            assert compact.is_playable(card) == game.is_playable(card)
+            assert compact.is_useless(card) == game.is_useless(card)
+            assert compact.is_critical(card) == game.is_critical(card)
+
+
+@pytest.mark.parametrize("board_class", [hs.Board] + COMPACT_BOARDS)
+def test_reset(board_class):
+    """Test that a reset board replays games exactly like fresh boards"""
+
+    reused = board_class(3)
+    hand_counts = reused.hand_counts
+    for seed in range(5):
+        deck = list(hs.DECK)
+        random.Random(seed).shuffle(deck)
+        reused.reset(list(deck))
+        reused.setup()
+        game = new_game(board_class, 3, deck)
+
+        rng, replay = random.Random(seed), random.Random(seed)
+        while not game.game_over:
+            player_id = game.turn % 3
+            game.resolve_move(player_id, random_move(game, player_id, rng))
+            reused.resolve_move(player_id, random_move(reused, player_id, replay))
+
+        assert reused.game_over and reused.turn == game.turn
+        assert reused.score == game.score
+        assert reused.num_strikes == game.num_strikes
+        assert reused.fireworks == game.fireworks
+        assert reused.player_hands == game.player_hands
+        assert reused.hand_counts == game.hand_counts
+        assert reused.player_counts == game.player_counts
+        assert dict(reused.discard_pile) == dict(game.discard_pile)
+        assert set(reused.critical_cards) == set(game.critical_cards)
+        assert set(reused.playable_cards) == set(game.playable_cards)
+        assert set(reused.dead_cards) == set(game.dead_cards)
+        assert list(reused.action_log) == list(game.action_log)
+
+    # Containers are cleared in place
+    assert reused.hand_counts is hand_counts
+
+
+@pytest.mark.parametrize("board_class", [hs.Board] + COMPACT_BOARDS)
+@pytest.mark.parametrize("seed", range(5))
+def test_snapshot_restore(board_class, seed):
+    """Test that restore returns to a snapshot after playing ahead"""
+
+    rng = random.Random(seed)
+    deck = list(hs.DECK)
+    rng.shuffle(deck)
+    game = new_game(board_class, 4, deck)
+    hand = game.get_hand(1, 0)
+
+    while not game.game_over:
+        state = game.snapshot()
+        log = list(game.action_log)
+
+        # Play the rest of the game, then return to this turn
+        rollout = random.Random(rng.random())
+        while not game.game_over:
+            player_id = game.turn % 4
+            game.resolve_move(player_id, random_move(game, player_id, rollout))
+        game.restore(state)
+
+        assert game.snapshot() == state
+        assert list(game.action_log) == log
+        assert list(hand) == [game.deck[i] for i in game.player_hands[1]]
+
+        player_id = game.turn % 4
+        game.resolve_move(player_id, random_move(game, player_id, rng))
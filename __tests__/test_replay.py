@@ -0,0 +1,103 @@
+import random
+import pytest
+from hanasim import hanasim as hs
+from hanasim import actionlog
+from hanasim import replay as hr
+from hanasim.native import BACKENDS
+from hanasim.packed import PackedBoard
+import agents.cheat_tobin as tobin
+
+
+def shuffled(index):
+    deck = list(hs.DECK)
+    random.Random(index).shuffle(deck)
+    return deck
+
+
+def play(num_players, index, board_class=PackedBoard):
+    """Play a shuffled deck with tobin's agents"""
+
+    game = board_class(num_players, shuffled(index))
+    players = [tobin.Agent(ii, game) for ii in range(num_players)]
+    for ii, player in enumerate(players):
+        game.set_player(player, ii)
+    game.setup()
+    return hs.play_game(game, players)
+
+
+@pytest.fixture()
+def logs(tmp_path):
+    """A log file of ten 3-player games and their final boards"""
+
+    path = str(tmp_path / "games.log")
+    games = {}
+    with actionlog.LogWriter(path) as writer:
+        for index in range(10, 20):
+            games[index] = play(3, index)
+            writer.write(index, games[index].action_log.view())
+    return path, games
+
+
+def test_logged_move():
+    """Test that logged moves are the moves resolved"""
+
+    game = hs.Board(3, list(hs.DECK))
+    game.setup()
+    moves = [
+        (0, (hs.PLAY, 1, hs.WHITE)),
+        (1, (hs.DISCARD, 4, 0)),
+        (2, (hs.HINTCOLOUR, 0, hs.WHITE)),
+        (0, (hs.HINTRANK, 1, 2)),
+    ]
+    for player_id, move in moves:
+        game.resolve_move(player_id, move)
+
+    assert [hr.logged_move(record) for record in game.action_log] == moves
+
+
+@pytest.mark.parametrize("board_class", BACKENDS.values())
+def test_replay(logs, board_class):
+    """Test that every backend re-scores the logged games"""
+
+    path, games = logs
+    replayed = list(hr.replay_logs(path, 3, shuffled, board_class))
+    assert [index for index, _ in replayed] == list(games)
+
+    # Boards are reused, so compare the last one only
+    index, game = replayed[-1]
+    assert game.deck == games[index].deck
+    assert game.game_over
+    assert game.score == games[index].score
+    assert game.num_strikes == games[index].num_strikes
+    assert game.turn == games[index].turn
+
+    differences = hr.verify_logs(path, 3, shuffled, board_class)
+    assert all(difference is None for _, difference, _ in differences)
+
+
+def test_verify_mismatch():
+    """Test that altered logs and decks are reported"""
+
+    played = play(4, 3)
+    records = list(played.action_log)
+    game = PackedBoard(4)
+    assert hr.verify(game, played.deck, records) is None
+
+    # Playing another slot changes the course of the game
+    turn = next(
+        i for i, record in enumerate(records)
+        if hs.decode_action(record)[0] == hs.PLAY and hs.decode_action(record)[4] != 0
+    )
+    action_type, player_id, _, value, _ = hs.decode_action(records[turn])
+    altered = list(records)
+    altered[turn] = hs.encode_action(action_type, player_id, 0, value, 0)
+    assert hr.verify(game, played.deck, altered).startswith("record ")
+
+    # A log cut short misses the game over record
+    assert hr.verify(game, played.deck, records[:-1]) is not None
+
+    # Moves out of turn and other decks are rejected
+    swapped = [records[1], records[0]] + records[2:]
+    assert hr.verify(game, played.deck, swapped).startswith("rejected move")
+    assert hr.verify(game, shuffled(4), records) is not None
+
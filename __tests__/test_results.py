@@ -0,0 +1,28 @@
+import numpy as np
+from unittest.mock import Mock
+from hanasim import results as hr
+
+
+def test_record():
+    """Test the result record of a game"""
+
+    game = Mock(score=20, num_strikes=1, turn=63, num_hints=2)
+    assert hr.record(game) == (20, 1, 63, 2)
+
+
+def test_shared_results():
+    """Test that writes through an attached view are seen by the creator"""
+
+    with hr.SharedResults.create(10) as results:
+        assert results.array.dtype == hr.RESULT_DTYPE
+        assert np.all(results.array["score"] == 0)
+
+        worker = hr.SharedResults.attach(results.name, 10)
+        worker.array[3] = (25, 0, 70, 4)
+        worker.array[9] = (11, 3, 41, 0)
+        worker.close()
+
+        assert results.array["score"][3] == 25
+        assert results.array["turns"][3] == 70
+        assert results.array["strikes"][9] == 3
+        assert list(results.array["hints"]) == [0, 0, 0, 4, 0, 0, 0, 0, 0, 0]
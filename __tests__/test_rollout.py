@@ -0,0 +1,168 @@
+import random
+import pytest
+from collections import Counter
+from unittest.mock import Mock
+from hanasim import hanasim as hs
+from hanasim import rollout as hr
+from hanasim.packed import CARD_BITS, PackedBoard
+import agents.cheat_tobin as tobin
+
+
+def new_game(seed, num_players=3, board_class=PackedBoard):
+    deck = list(hs.DECK)
+    random.Random(seed).shuffle(deck)
+    game = board_class(num_players, deck)
+    game.setup()
+    return game
+
+
+def test_sample_keeps_visible_cards():
+    """Test that samples only deal the observer's unseen cards"""
+
+    game = new_game(0)
+    game.resolve_move(0, (hs.DISCARD, 0, None))
+    engine = hr.Rollouts(hr.agent_policy(tobin), random.Random(0))
+    engine.prepare(game, 1)
+    unseen = game.player_hands[1] + list(range(game.index, 50))
+
+    for _ in range(20):
+        deck = engine.sample()
+        for position in range(50):
+            if position not in unseen:
+                assert deck[position] == game.deck[position]
+        sampled = Counter(deck[position] for position in unseen)
+        assert sampled == Counter(game.deck[position] for position in unseen)
+
+
+def test_sample_slot_masks():
+    """Test that slot masks restrict the cards of the sampled hand"""
+
+    game = new_game(1)
+    engine = hr.Rollouts(hr.agent_policy(tobin), random.Random(1))
+    engine.prepare(game, 0)
+
+    # Slot 0 is known to hold the card it holds, slot 1 any one
+    card = game.deck[game.player_hands[0][0]]
+    ones = sum(CARD_BITS[hs.Card(colour, hs.ONE)] for colour in hs.COLOURS)
+    for _ in range(20):
+        deck = engine.sample([CARD_BITS[card], ones])
+        assert deck[game.player_hands[0][0]] == card
+        assert deck[game.player_hands[0][1]].rank == hs.ONE
+
+
+def test_sample_trades_slots():
+    """Test that a card taken by an earlier slot goes to the slot needing it"""
+
+    game = new_game(1)
+    engine = hr.Rollouts(hr.agent_policy(tobin), random.Random(1))
+    engine.prepare(game, 0)
+
+    # Slot 0 holds A or B and slot 1 holds A, the only unseen copy of A
+    copies = Counter(engine.pool)
+    single, other = [card for card, count in copies.items() if count == 1][:2]
+    masks = [CARD_BITS[single] | CARD_BITS[other], CARD_BITS[single]]
+    hand = game.player_hands[0]
+    for _ in range(20):
+        deck = engine.sample(masks)
+        assert [deck[hand[0]], deck[hand[1]]] == [other, single]
+
+    with pytest.raises(ValueError):
+        engine.sample([CARD_BITS[single], CARD_BITS[single]])
+
+
+def hand_counts(game, player_id=None):
+    """Counts of the card codes held by a player, or in all hands"""
+
+    counts = [0] * hs.NUM_CARD_TYPES
+    for hand_owner, hand in enumerate(game.player_hands):
+        if player_id is None or hand_owner == player_id:
+            for position in hand:
+                counts[hs.card_code(game.deck[position])] += 1
+    return counts
+
+
+@pytest.mark.parametrize("board_class", [hs.Board, PackedBoard])
+def test_sampled_counts(board_class):
+    """Test that visible counts follow the sampled hand of the observer"""
+
+    game = new_game(5, board_class=board_class)
+    engine = hr.Rollouts(hr.agent_policy(tobin), random.Random(5))
+    engine.prepare(game, 0)
+    state = game.snapshot()
+
+    game.replace_deck(engine.sample())
+    assert game.hand_counts == hand_counts(game)
+    for player_id in range(game.num_players):
+        assert game.player_counts[player_id] == hand_counts(game, player_id)
+    for card in hs.CARDS:
+        seen = sum(
+            hand_counts(game, player_id)[hs.card_code(card)]
+            for player_id in range(game.num_players)
+            if player_id != 1
+        )
+        assert game.visible_count(1, card) == seen
+    game.restore(state)
+
+    # Rollouts keep the counts in step with the sampled deck
+    def counted(rolled_out):
+        assert rolled_out.hand_counts == hand_counts(rolled_out)
+        return rolled_out.score
+
+    hr.Rollouts(hr.agent_policy(tobin), random.Random(5), counted).evaluate(game, 0, 3)
+    assert game.hand_counts == hand_counts(game)
+
+
+@pytest.mark.parametrize("board_class", [hs.Board, PackedBoard])
+def test_evaluate(board_class):
+    """Test value estimates of all legal actions, leaving the board as it was"""
+
+    game = new_game(2, board_class=board_class)
+    players = [Mock() for _ in range(game.num_players)]
+    for player_id, player in enumerate(players):
+        game.set_player(player, player_id)
+    state = game.snapshot()
+    engine = hr.Rollouts(hr.agent_policy(tobin), random.Random(2))
+
+    values = engine.evaluate(game, 0, 4)
+
+    legal = game.legal_actions(0)
+    legal_actions = [i for i in range(game.num_actions) if legal >> i & 1]
+    assert sorted(values.counts) == legal_actions
+    assert all(count == 4 for count in values.counts.values())
+    assert all(0 <= value <= 25 for value in values.values().values())
+    assert game.snapshot() == state
+    assert game.players == players
+    assert game.listeners[hs.DRAW] == [player.draw for player in players]
+    for player in players:
+        assert not player.mock_calls
+
+    with pytest.raises(ValueError):
+        engine.evaluate(game, 1, 1)
+
+
+def test_merge():
+    """Test that evaluations with different seeds merge"""
+
+    game = new_game(3)
+    engines = [hr.Rollouts(hr.agent_policy(tobin), random.Random(i)) for i in range(2)]
+    first = engines[0].evaluate(game, 0, 3, [0, 5])
+    second = engines[1].evaluate(game, 0, 2, [0, 5])
+    total = first.totals[0] + second.totals[0]
+
+    merged = first.merge(second)
+    assert merged.counts == {0: 5, 5: 5}
+    assert merged.value(0) == pytest.approx(total / 5)
+    assert merged.best() in (0, 5)
+
+
+def test_value():
+    """Test a custom value of rolled out games"""
+
+    game = new_game(4)
+    engine = hr.Rollouts(hr.agent_policy(tobin), random.Random(4), lambda game: -1)
+    values = engine.evaluate(game, 0, 2, [0, 5, 10])
+    assert values.values() == {0: -1, 5: -1, 10: -1}
+
+    # Ties go to the action evaluated first
+    assert values.best() == 0
+    assert engine.evaluate(game, 0, 1, [10, 0]).best() == 10
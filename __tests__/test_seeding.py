@@ -0,0 +1,43 @@
+import numpy as np
+from hanasim import hanasim as hs
+from hanasim import seeding
+
+
+def test_game_deck_deterministic():
+    """Test that a game's deck only depends on seed and game index"""
+
+    assert seeding.game_deck(7, 123) == seeding.game_deck(7, 123)
+    assert seeding.game_deck(7, 123) != seeding.game_deck(7, 124)
+    assert seeding.game_deck(7, 123) != seeding.game_deck(8, 123)
+    assert sorted(seeding.game_deck(7, 123)) == sorted(hs.DECK)
+
+
+def test_game_seed_matches_spawn():
+    """Test that game seeds are the children of the sweep seed sequence"""
+
+    children = np.random.SeedSequence(3).spawn(5)
+    for index, child in enumerate(children):
+        ours = seeding.game_seed(3, index)
+        assert np.all(ours.generate_state(4) == child.generate_state(4))
+
+
+def test_game_decks_chunking():
+    """Test that batches of decks do not depend on where a chunk starts"""
+
+    whole = seeding.game_decks(11, 0, 20)
+    parts = np.concatenate(
+        [seeding.game_decks(11, 0, 7), seeding.game_decks(11, 7, 13)]
+    )
+    assert np.array_equal(whole, parts)
+
+    for index in range(20):
+        deck = seeding.game_deck(11, index)
+        assert list(whole[index]) == [hs.card_code(card) for card in deck]
+
+
+def test_generate_deck_rng():
+    """Test that Board.generate_deck shuffles with the given generator"""
+
+    game = hs.Board(2)
+    game.generate_deck(seeding.game_rng(5, 0))
+    assert game.deck == seeding.game_deck(5, 0)
@@ -0,0 +1,182 @@
+import math
+import random
+import pytest
+from hanasim import hanasim as hs
+from hanasim.packed import PackedBoard
+from hanasim.seeding import game_deck
+from hanasim.stats import (
+    Moments,
+    PairedStats,
+    ScoreStats,
+    MAXSCORE,
+    results_table,
+    stats_from_dict,
+)
+import agents.cheat_tobin as tobin
+
+
+def random_results(n, seed):
+    rng = random.Random(seed)
+    return [
+        (rng.randint(0, MAXSCORE), rng.choice([0, 1, 2, 3]), rng.randint(40, 90))
+        for _ in range(n)
+    ]
+
+
+def aggregate(results):
+    stats = ScoreStats()
+    for result in results:
+        stats.update(*result)
+    return stats
+
+
+def test_moments():
+    """Test the streaming mean and variance against a direct calculation"""
+
+    results = random_results(1000, 0)
+    stats = aggregate(results)
+    scores = [score for score, _, _ in results]
+    mean = sum(scores) / len(scores)
+    variance = sum((s - mean) ** 2 for s in scores) / (len(scores) - 1)
+
+    assert stats.count == 1000
+    assert stats.mean == pytest.approx(mean)
+    assert stats.variance == pytest.approx(variance)
+    assert stats.stderr == pytest.approx(math.sqrt(variance / 1000))
+    assert stats.ci_halfwidth() == pytest.approx(1.96 * stats.stderr)
+
+
+def test_histograms_and_rates():
+    """Test the histograms and strike-out and perfect game rates"""
+
+    stats = aggregate([(25, 0, 60), (25, 1, 70), (10, 3, 30), (20, 2, 70)])
+
+    assert stats.score_hist[25] == 2
+    assert stats.score_hist[10] == 1
+    assert stats.turn_hist[70] == 2
+    assert stats.strikeout_rate == 0.25
+    assert stats.perfect_rate == 0.5
+    assert stats.quantile(0.25) == 10
+    assert stats.quantile(0.5) == 20
+    assert stats.quantile(1.0) == 25
+    assert stats.quantile(0.5, stats.turn_hist) == 60
+
+
+def test_merge():
+    """Test that merging chunk aggregates equals a single pass"""
+
+    results = random_results(500, 1)
+    whole = aggregate(results)
+    merged = ScoreStats()
+    for start in range(0, 500, 73):
+        merged.merge(aggregate(results[start : start + 73]))
+
+    assert merged.count == whole.count
+    assert merged.mean == pytest.approx(whole.mean)
+    assert merged.variance == pytest.approx(whole.variance)
+    assert merged.strikeouts == whole.strikeouts
+    assert merged.score_hist == whole.score_hist
+    assert merged.turn_hist == whole.turn_hist
+
+
+def test_empty():
+    """Test that empty aggregates merge and report without errors"""
+
+    stats = ScoreStats().merge(ScoreStats())
+    assert stats.count == 0
+    assert stats.variance == 0.0
+    assert stats.strikeout_rate == 0.0
+    assert math.isinf(stats.stderr)
+    assert "0 games" in stats.progress()
+
+    # One game bounds nothing, so precision targets are never met
+    stats.update(25, 0, 60)
+    assert math.isinf(stats.ci_halfwidth())
+
+
+def test_add_game():
+    """Test aggregating finished games"""
+
+    stats = ScoreStats()
+    scores = []
+    for index in range(10):
+        game = PackedBoard(3, game_deck(0, index))
+        game.setup()
+        hs.play_game(game, [tobin.Agent(i, game) for i in range(3)])
+        stats.add_game(game)
+        scores.append(game.score)
+
+    assert stats.count == 10
+    assert stats.mean == pytest.approx(sum(scores) / 10)
+    assert sum(stats.turn_hist) == 10
+    assert "mean score" in stats.summary()
+
+
+def test_to_dict():
+    """Test that aggregates survive a round trip through plain dicts"""
+
+    stats = aggregate(random_results(100, 2))
+    copy = stats_from_dict(stats.to_dict())
+
+    assert type(copy) is ScoreStats
+    assert copy.to_dict() == stats.to_dict()
+    assert copy.merge(stats).count == 200
+
+    paired = PairedStats()
+    paired.first, paired.second = stats, aggregate(random_results(100, 3))
+    copy = stats_from_dict(paired.to_dict())
+    assert type(copy.first) is ScoreStats
+    assert copy.to_dict() == paired.to_dict()
+
+    with pytest.raises(ValueError):
+        stats_from_dict({"kind": "Board"})
+
+
+def play(agent, num_players, deck):
+    game = PackedBoard(num_players, deck)
+    game.setup()
+    return hs.play_game(game, [agent.Agent(i, game) for i in range(num_players)])
+
+
+def test_paired():
+    """Test the paired difference of two agents on the same decks"""
+
+    paired = PairedStats()
+    differences = Moments()
+    for index in range(20):
+        first = play(tobin, 2, game_deck(1, index))
+        second = play(tobin, 4, game_deck(1, index))
+        paired.add_games(first, second)
+        differences.update(first.score - second.score)
+
+    assert paired.count == paired.first.count == paired.second.count == 20
+    assert paired.mean == pytest.approx(paired.first.mean - paired.second.mean)
+    assert paired.variance == pytest.approx(differences.variance)
+
+    halves = PairedStats()
+    for index in range(0, 20, 10):
+        half = PairedStats()
+        for i in range(index, index + 10):
+            deck = game_deck(1, i)
+            half.add_games(play(tobin, 2, deck), play(tobin, 4, deck))
+        halves.merge(half)
+
+    assert halves.mean == pytest.approx(paired.mean)
+    assert halves.variance == pytest.approx(paired.variance)
+    assert halves.first.score_hist == paired.first.score_hist
+    assert "difference" in halves.summary()
+
+
+def test_results_table():
+    """Test that the table has one aligned row per cell"""
+
+    cells = {
+        ("cheat_tobin", 2): aggregate([(25, 0, 60), (24, 0, 62)]),
+        ("cheat_tobin", 5): aggregate([(25, 0, 40)]),
+    }
+    lines = results_table(cells).splitlines()
+
+    assert len(lines) == 3
+    assert lines[0].split()[:3] == ["agent", "players", "games"]
+    assert lines[1].split()[:4] == ["cheat_tobin", "2", "2", "24.500"]
+    assert len({len(line) for line in lines}) == 1
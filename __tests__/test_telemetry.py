@@ -0,0 +1,78 @@
+import random
+import pytest
+from hanasim import hanasim as hs
+from hanasim import telemetry as ht
+from hanasim.native import BACKENDS
+import agents.cheat_tobin as tobin
+
+
+def play(board_class, num_players, seed):
+    deck = list(hs.DECK)
+    random.Random(seed).shuffle(deck)
+    game = board_class(num_players, deck)
+    players = [tobin.Agent(ii, game) for ii in range(num_players)]
+    for ii, player in enumerate(players):
+        game.set_player(player, ii)
+    game.setup()
+    return hs.play_game(game, players)
+
+
+@pytest.mark.parametrize("board_class", BACKENDS.values())
+def test_record_turns(board_class):
+    """Test that every turn is recorded with the state before its move"""
+
+    recorder = ht.TurnRecorder()
+    recorder.game_index = 7
+    game = play(ht.record_turns(board_class, recorder), 3, 0)
+    reference = play(board_class, 3, 0)
+
+    rows = recorder.rows()
+    assert len(rows) == game.turn == reference.turn
+    assert [row[0] for row in rows] == [7] * len(rows)
+    assert [row[1] for row in rows] == list(range(len(rows)))
+    assert [row[2] for row in rows] == [turn % 3 for turn in range(len(rows))]
+
+    moves = [hs.decode_action(record) for record in reference.action_log]
+    assert [row[3] for row in rows] == [move[0] for move in moves[: len(rows)]]
+
+    # The first turn starts from a fresh board with 35 cards left to draw
+    assert rows[0][4:] == (hs.Board.MAXHINTS, 0, 35 + 3 - 25, 0)
+    assert all(row[5] < hs.Board.MAXSTRIKES for row in rows)
+    assert rows[-1][7] <= game.score
+
+
+def test_sink(tmp_path):
+    """Test that chunks are written to one Parquet file per partition"""
+
+    pytest.importorskip("pyarrow")
+    sink = ht.TelemetrySink(str(tmp_path), batch_size=50)
+    turns = 0
+    for start in (0, 2):
+        sink.start_chunk(start)
+        for index in range(start, start + 2):
+            sink.set_game(index)
+            for num_players in (2, 4):
+                recorder = sink.recorder("cheat_tobin", num_players)
+                board_class = ht.record_turns(hs.Board, recorder)
+                turns += play(board_class, num_players, index).turn
+        sink.finish_chunk()
+
+    partition = tmp_path / "agent=cheat_tobin" / "players=4"
+    assert sorted(path.name for path in partition.iterdir()) == [
+        "part-000000000000.parquet",
+        "part-000000000002.parquet",
+    ]
+
+    table = ht.read_telemetry(str(tmp_path), columns=["game", "players", "hints"])
+    assert table.num_rows == turns
+    assert table.column_names == ["game", "players", "hints"]
+    assert sorted(set(table.column("game").to_pylist())) == [0, 1, 2, 3]
+
+    # Chunks played again replace their files
+    sink.start_chunk(2)
+    sink.set_game(2)
+    play(ht.record_turns(hs.Board, sink.recorder("cheat_tobin", 2)), 2, 2)
+    sink.finish_chunk()
+    assert len(list(partition.iterdir())) == 2
+    table = ht.read_telemetry(str(tmp_path), columns=["game"])
+    assert table.num_rows < turns
@@ -15,18 +15,23 @@ class Agent:
     This player cheats by inspecting its own hand.
     """
 
+    # A cheating player needs no notifications from the board
+    EVENTS = frozenset()
+
     def __init__(self, player_id, game):
         self.player_id = player_id
 
+    def reset(self, game):
+        """Start a new game, the agent keeps no state between moves"""
+
     def find_move(self, game):
 
         indices = game.player_hands[self.player_id]
         hand = [game.deck[i] for i in indices]
 
         # Try to play a card
-        playable_cards = game.playable_cards
         for index, card in enumerate(hand):
-            if card in playable_cards:
+            if game.is_playable(card):
                 action = (hs.PLAY, index, card.colour)
                 return action
 
@@ -42,7 +47,7 @@ class Agent:
             - (game.num_players * game.handsize)
         )
 
-        if game.num_discarded < discard_threshold or game.num_hints == 0:
+        if game.total_discarded < discard_threshold or game.num_hints == 0:
             action = self.find_useless_card(game, hand)
             if action:
                 return action
@@ -68,29 +73,32 @@ class Agent:
     def find_useless_card(self, game, hand):
         """Find a card that is has been played or is otherwise dead"""
         for index, card in enumerate(hand):
-            if card in game.played_cards or card in game.dead_cards:
+            if game.is_useless(card):
                 return (hs.DISCARD, index, None)
 
         return None
 
     def find_non_critical(self, game, hand):
         for index, card in enumerate(hand):
-            if card not in game.critical_cards:
+            if not game.is_critical(card):
                 return (hs.DISCARD, index, None)
 
         return None
     
     def find_duplicate(self, game, hand):
         """ Find a card held by another player """
-        other_hands = [game.player_hands[player] for player in 
-                range(game.num_players) if player is not self.player_id]
-        other_cards = set([game.deck[i] for hand in other_hands for i in hand])
-
         for index, card in enumerate(hand):
-            if card in other_cards:
+            if game.visible_count(self.player_id, card):
                 return (hs.DISCARD, index, None)
 
         return None
 
 
+def __getattr__(name):
+    """Import BatchAgent on first use, as it needs numpy and hanasim.batch"""
+
+    if name == "BatchAgent":
+        from agents.cheat_tobin_batch import BatchAgent
 
+        return BatchAgent
+    raise AttributeError(f"module {__name__!r} has no attribute {name!r}")
@@ -0,0 +1,71 @@
+import numpy as np
+import hanasim.hanasim as hs
+from hanasim.batch import AbstractBatchAgent
+
+
+class BatchAgent(AbstractBatchAgent):
+    """
+    Vectorized version of cheat_tobin.Agent that picks the moves of all
+    games in a hanasim.batch.BatchBoard at once, following the same priorities.
+    """
+
+    def find_moves(self, batch):
+        """Apply the strategy of Agent to the current player of every game"""
+
+        num_games, num_players = batch.num_games, batch.num_players
+        rows = np.arange(num_games)
+        players = batch.current_player
+
+        # Card codes of every hand, -1 for empty slots
+        positions = batch.hands.astype(np.intp)
+        all_cards = batch.decks[rows[:, None, None], np.maximum(positions, 0)]
+        all_cards = np.where(positions >= 0, all_cards, -1)
+
+        cards = all_cards[rows, players]
+        held = cards >= 0
+        codes = np.where(held, cards, 0)
+
+        def has_code(masks):
+            return held & (((masks[:, None] >> codes) & 1) == 1)
+
+        playable = has_code(batch.playable)
+        useless = has_code(batch.useless)
+        non_critical = held & ~has_code(batch.critical)
+
+        # A card is a duplicate if another player holds the same card
+        others = np.arange(num_players)[None, :] != players[:, None]
+        other_cards = np.where(others[:, :, None], all_cards, -1)
+        other_cards = other_cards.reshape(num_games, -1)
+        duplicate = held & (cards[:, :, None] == other_cards[:, None, :]).any(axis=2)
+
+        discard_threshold = (
+            batch.NUMCARDS
+            - len(hs.COLOURS) * len(hs.RANKS)
+            - (num_players * batch.handsize)
+        )
+        pace_discard = (batch.total_discarded < discard_threshold) | (
+            batch.num_hints == 0
+        )
+        hint = (players + 1) % num_players
+
+        # Moves in order of priority, the first one whose condition holds wins
+        play_slot = playable.argmax(axis=1)
+        moves = [
+            (playable.any(axis=1), hs.PLAY, play_slot),
+            (batch.num_hints == batch.MAXHINTS, hs.HINTCOLOUR, hint),
+            (pace_discard & useless.any(axis=1), hs.DISCARD, useless.argmax(axis=1)),
+            (batch.num_hints > 0, hs.HINTCOLOUR, hint),
+            (duplicate.any(axis=1), hs.DISCARD, duplicate.argmax(axis=1)),
+            (non_critical.any(axis=1), hs.DISCARD, non_critical.argmax(axis=1)),
+        ]
+        conditions = [condition for condition, _, _ in moves]
+        action_types = np.select(
+            conditions,
+            [np.full(num_games, action_type) for _, action_type, _ in moves],
+            hs.DISCARD,
+        )
+        targets = np.select(conditions, [target for _, _, target in moves], 0)
+        values = np.where(
+            conditions[0], codes[rows, play_slot] // len(hs.RANKS), 0
+        )
+        return action_types, targets, values
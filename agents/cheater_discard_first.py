@@ -8,12 +8,16 @@ class Agent:
         2. Discard first card
     """
 
-
+    # A cheating player needs no notifications from the board
+    EVENTS = frozenset()
 
     def __init__(self, playerID, game):
 
         self.playerID = playerID
 
+    def reset(self, game):
+        """Start a new game, the agent keeps no state between moves"""
+
     def find_move(self, game):
         """
         Computes move according to priorities set in class description
@@ -34,3 +38,13 @@ class Agent:
         # Discard first card
         action = (hs.DISCARD, 0, None)
         return action
+
+
+def __getattr__(name):
+    """Import BatchAgent on first use, as it needs numpy and hanasim.batch"""
+
+    if name == "BatchAgent":
+        from agents.cheater_discard_first_batch import BatchAgent
+
+        return BatchAgent
+    raise AttributeError(f"module {__name__!r} has no attribute {name!r}")
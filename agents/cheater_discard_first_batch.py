@@ -0,0 +1,27 @@
+import numpy as np
+import hanasim.hanasim as hs
+from hanasim.batch import AbstractBatchAgent
+
+
+class BatchAgent(AbstractBatchAgent):
+    """
+    Vectorized version of cheater_discard_first.Agent that picks the moves
+    of all games in a hanasim.batch.BatchBoard at once.
+    """
+
+    def find_moves(self, batch):
+        """Play the first playable card in hand, otherwise discard first card"""
+
+        cards = batch.hand_cards()
+        held = cards >= 0
+        codes = np.where(held, cards, 0)
+        playable = held & (((batch.playable[:, None] >> codes) & 1) == 1)
+
+        can_play = playable.any(axis=1)
+        first = playable.argmax(axis=1)
+        colours = codes[np.arange(batch.num_games), first] // len(hs.RANKS)
+
+        action_types = np.where(can_play, hs.PLAY, hs.DISCARD)
+        targets = np.where(can_play, first, 0)
+        values = np.where(can_play, colours, 0)
+        return action_types, targets, values
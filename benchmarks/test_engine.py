@@ -0,0 +1,129 @@
+"""
+Micro benchmarks of the Board hot paths, run with pytest-benchmark:
+
+    pytest benchmarks --benchmark-autosave
+"""
+
+import copy
+import numpy as np
+import pytest
+from hanasim import hanasim as hs
+from hanasim.packed import PackedBoard
+from hanasim.native import NativeBoard
+from hanasim.batch import BatchBoard
+from hanasim.observation import ObservationEncoder
+from hanasim.seeding import game_deck, game_rng
+
+BOARDS = [hs.Board, PackedBoard, NativeBoard]
+ROUNDS = 2000
+
+
+def new_game(board_class, num_players, index=0):
+    game = board_class(num_players, game_deck(0, index))
+    game.setup()
+    return game
+
+
+@pytest.mark.parametrize("board_class", BOARDS)
+@pytest.mark.parametrize(
+    "action", [(hs.PLAY, 0, hs.WHITE), (hs.DISCARD, 0, None), (hs.HINTCOLOUR, 1, 0)]
+)
+def test_resolve_move(benchmark, board_class, action):
+    """Time a single resolve_move, dealing a fresh game between rounds"""
+
+    def setup():
+        return (new_game(board_class, 5), 0, action), {}
+
+    benchmark.pedantic(board_class.resolve_move, setup=setup, rounds=ROUNDS)
+
+
+@pytest.mark.parametrize("board_class", BOARDS)
+def test_play(benchmark, board_class):
+    """Time Board.play, rebuilding the game between rounds"""
+
+    def setup():
+        return (new_game(board_class, 5), 0, 0), {}
+
+    benchmark.pedantic(board_class.play, setup=setup, rounds=ROUNDS)
+
+
+@pytest.mark.parametrize("board_class", BOARDS)
+def test_discard(benchmark, board_class):
+    """Time Board.discard, rebuilding the game between rounds"""
+
+    def setup():
+        return (new_game(board_class, 5), 0, 0), {}
+
+    benchmark.pedantic(board_class.discard, setup=setup, rounds=ROUNDS)
+
+
+@pytest.mark.parametrize("board_class", BOARDS)
+def test_playable_cards(benchmark, board_class):
+    """Time the playable card queries agents run every turn"""
+
+    game = new_game(board_class, 5)
+    hand = [game.deck[i] for i in game.player_hands[0]]
+
+    def query():
+        game.playable_cards
+        for card in hand:
+            game.is_playable(card)
+
+    benchmark(query)
+
+
+@pytest.mark.parametrize("board_class", BOARDS)
+def test_snapshot_restore(benchmark, board_class):
+    """Time a snapshot, one move ahead and the restore a search step costs"""
+
+    game = new_game(board_class, 5)
+
+    def step():
+        state = game.snapshot()
+        game.resolve_move(0, (hs.DISCARD, 0, None))
+        game.restore(state)
+
+    benchmark(step)
+
+
+@pytest.mark.parametrize("board_class", BOARDS)
+def test_encode(benchmark, board_class):
+    """Time encoding one observation into a reused buffer"""
+
+    game = new_game(board_class, 5)
+    encoder = ObservationEncoder(5)
+    out = np.zeros(encoder.size, dtype=np.float32)
+    benchmark(encoder.encode, game, 0, out)
+
+
+def test_encode_batch(benchmark):
+    """Time encoding the observations of 1000 games into a reused buffer"""
+
+    batch = BatchBoard(1000, 5)
+    batch.seed_decks(0)
+    batch.setup()
+    encoder = ObservationEncoder(5)
+    out = np.zeros((batch.num_games, encoder.size), dtype=np.float32)
+    benchmark(encoder.encode_batch, batch, None, out)
+
+
+@pytest.mark.parametrize("board_class", BOARDS)
+def test_deepcopy(benchmark, board_class):
+    """Time copy.deepcopy of a board, the baseline snapshot replaces"""
+
+    game = new_game(board_class, 5)
+    benchmark(copy.deepcopy, game)
+
+
+def test_generate_deck(benchmark):
+    """Time shuffling with the global random module"""
+
+    game = hs.Board(5)
+    benchmark(game.generate_deck)
+
+
+def test_generate_deck_seeded(benchmark):
+    """Time shuffling with a per-game generator, including its creation"""
+
+    game = hs.Board(5)
+    benchmark(lambda: game.generate_deck(game_rng(0, 1)))
@@ -0,0 +1,151 @@
+"""
+Throughput of full games for every agent in agents/ across player counts.
+Besides the time per round, games/sec, us/turn and the garbage collections
+per game are stored in extra_info of the saved benchmark results, compare
+runs with
+
+    pytest benchmarks --benchmark-compare
+
+test_allocation_budget fails when a phase of a game on a reused board
+allocates more bytes per turn than HANASIM_ALLOCATION_BUDGET, 1024 by default.
+"""
+
+import gc
+import importlib
+import os
+import pytest
+import numpy as np
+from hanasim import hanasim as hs
+from hanasim.batch import BatchBoard, play_batch
+from hanasim.memory import MemoryCounters, TrackedAgent, track, traced
+from hanasim.packed import PackedBoard
+from hanasim.native import NativeBoard
+from hanasim.seeding import game_deck
+
+AGENTS = ["agents.cheat_tobin", "agents.cheater_discard_first"]
+GAMES = 200
+BATCHSIZE = 4096
+ALLOCATION_BUDGET = float(os.environ.get("HANASIM_ALLOCATION_BUDGET", 1024))
+
+
+def record_throughput(benchmark, games, turns):
+    """Store games/sec and us/turn of the mean round"""
+
+    mean = benchmark.stats.stats.mean
+    benchmark.extra_info["games_per_sec"] = games / mean
+    benchmark.extra_info["us_per_turn"] = 1e6 * mean / turns
+
+
+def collections():
+    """Number of garbage collections run so far, over all generations"""
+    return sum(stats["collections"] for stats in gc.get_stats())
+
+
+def run_counting_gc(benchmark, run, games):
+    """Benchmark run and store the garbage collections per game it caused"""
+
+    rounds = 5
+    before = collections()
+    turns = benchmark.pedantic(run, rounds=rounds, warmup_rounds=1)
+    benchmark.extra_info["gc_per_game"] = (
+        (collections() - before) / ((rounds + 1) * games)
+    )
+    return turns
+
+
+@pytest.mark.parametrize("board_class", [hs.Board, PackedBoard, NativeBoard])
+@pytest.mark.parametrize("num_players", [2, 3, 4, 5])
+@pytest.mark.parametrize("agent_name", AGENTS)
+def test_full_games(benchmark, agent_name, num_players, board_class):
+    """Play GAMES seeded games with one agent"""
+
+    agent = importlib.import_module(agent_name)
+    decks = [game_deck(0, index) for index in range(GAMES)]
+
+    def run():
+        turns = 0
+        for deck in decks:
+            game = board_class(num_players, deck)
+            game.setup()
+            players = [agent.Agent(i, game) for i in range(num_players)]
+            turns += hs.play_game(game, players).turn
+        return turns
+
+    turns = run_counting_gc(benchmark, run, GAMES)
+    record_throughput(benchmark, GAMES, turns)
+
+
+@pytest.mark.parametrize("board_class", [hs.Board, PackedBoard, NativeBoard])
+@pytest.mark.parametrize("num_players", [2, 3, 4, 5])
+@pytest.mark.parametrize("agent_name", AGENTS)
+def test_reused_games(benchmark, agent_name, num_players, board_class):
+    """Play GAMES seeded games with one agent on a single reset board"""
+
+    agent = importlib.import_module(agent_name)
+    decks = [game_deck(0, index) for index in range(GAMES)]
+    game = board_class(num_players)
+    players = [agent.Agent(i, game) for i in range(num_players)]
+
+    def run():
+        turns = 0
+        for deck in decks:
+            game.reset(deck)
+            game.setup()
+            for player in players:
+                player.reset(game)
+            turns += hs.play_game(game, players).turn
+        return turns
+
+    turns = run_counting_gc(benchmark, run, GAMES)
+    record_throughput(benchmark, GAMES, turns)
+
+
+@pytest.mark.parametrize("board_class", [hs.Board, PackedBoard, NativeBoard])
+@pytest.mark.parametrize("num_players", [2, 5])
+@pytest.mark.parametrize("agent_name", AGENTS)
+def test_allocation_budget(benchmark, agent_name, num_players, board_class):
+    """Trace the allocations per turn of the engine and the agent"""
+
+    agent = importlib.import_module(agent_name)
+    decks = [game_deck(0, index) for index in range(GAMES // 10)]
+    counters = MemoryCounters()
+    game = track(board_class, counters)(num_players)
+    players = [
+        TrackedAgent(agent.Agent(i, game), counters, agent_name)
+        for i in range(num_players)
+    ]
+
+    def play(deck):
+        game.reset(deck)
+        game.setup()
+        for player in players:
+            player.reset(game)
+        return hs.play_game(game, players)
+
+    def run():
+        counters.clear()
+        for deck in decks:
+            traced(counters, play, deck)
+
+    benchmark.pedantic(run, rounds=1, warmup_rounds=1)
+    for phase in counters.calls:
+        benchmark.extra_info[f"bytes_per_turn:{phase}"] = counters.per_turn(phase)
+    assert counters.over_budget(ALLOCATION_BUDGET) == []
+
+
+@pytest.mark.parametrize("agent_name", AGENTS)
+@pytest.mark.parametrize("num_players", [2, 3, 4, 5])
+def test_batch_games(benchmark, agent_name, num_players):
+    """Play BATCHSIZE seeded games in lockstep with the agent's BatchAgent"""
+
+    agent = importlib.import_module(agent_name).BatchAgent()
+
+    def run():
+        batch = BatchBoard(BATCHSIZE, num_players)
+        batch.seed_decks(0)
+        batch.setup()
+        play_batch(batch, agent)
+        return int(np.sum(batch.turn))
+
+    turns = benchmark.pedantic(run, rounds=5, warmup_rounds=1)
+    record_throughput(benchmark, BATCHSIZE, turns)
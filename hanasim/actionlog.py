@@ -0,0 +1,149 @@
+"""
+Storage and export of encoded action logs.
+
+LogWriter appends the action records of many games to a single file. Each game
+is stored as a little-endian header of game index (8 bytes) and number of
+records (2 bytes), followed by its 4-byte records, see hanasim.encode_action.
+pack_log encodes a game the same way, so workers can collect the logs of a
+chunk in one buffer for the driver to append. Logs are only decoded on
+demand, e.g. into the JSON format that hanab.live imports to replay a game.
+"""
+
+import json
+import os
+import struct
+import sys
+from array import array
+from typing import Iterator, List, Tuple
+
+from hanasim.hanasim import (
+    CARDS,
+    Card,
+    DISCARD,
+    ENDGAME,
+    HINTCOLOUR,
+    HINTRANK,
+    PLAY,
+    RECORD_TYPECODE,
+    decode_action,
+)
+
+GAME_HEADER = struct.Struct("<QH")
+
+# Action types as numbered by hanab.live
+HANAB_LIVE_TYPES = {PLAY: 0, DISCARD: 1, HINTCOLOUR: 2, HINTRANK: 3, ENDGAME: 4}
+
+
+def _as_records(records) -> array:
+    """Copy a buffer of native uint32 records into a little-endian array"""
+
+    data = array(RECORD_TYPECODE)
+    data.frombytes(memoryview(records).cast("B"))
+    if sys.byteorder == "big":
+        data.byteswap()
+    return data
+
+
+def pack_log(game_index: int, records) -> bytes:
+    """Header and records of a game as stored in a log file, see LogWriter"""
+
+    data = _as_records(records)
+    return GAME_HEADER.pack(game_index, len(data)) + data.tobytes()
+
+
+class LogWriter:
+    """Append-only writer of game logs to a single file"""
+
+    def __init__(self, path: str) -> None:
+        self.file = open(path, "ab")
+
+    def write(self, game_index: int, records) -> None:
+        """
+        Append the log of a game. Records may be an ActionLog view or any
+        contiguous buffer of uint32 records, e.g. a row of BatchBoard.logs.
+        """
+
+        self.file.write(pack_log(game_index, records))
+
+    def write_packed(self, data: bytes) -> None:
+        """Append game logs packed with pack_log, e.g. a worker's chunk"""
+        self.file.write(data)
+
+    def flush(self) -> None:
+        """Write the appended logs through to disk"""
+
+        self.file.flush()
+        os.fsync(self.file.fileno())
+
+    def tell(self) -> int:
+        """Size of the file with the logs appended so far"""
+        return self.file.tell()
+
+    def truncate(self, size: int) -> None:
+        """Cut the file back to size bytes, e.g. the end of a checkpoint"""
+
+        self.file.flush()
+        self.file.truncate(size)
+        self.file.seek(size)
+
+    def close(self) -> None:
+        self.file.close()
+
+    def __enter__(self) -> "LogWriter":
+        return self
+
+    def __exit__(self, *exc) -> None:
+        self.close()
+
+
+def read_logs(path: str) -> Iterator[Tuple[int, array]]:
+    """Iterate over the (game index, records) pairs stored in a log file"""
+
+    with open(path, "rb") as f:
+        while True:
+            header = f.read(GAME_HEADER.size)
+            if not header:
+                return
+            if len(header) < GAME_HEADER.size:
+                raise ValueError(f"{path} is truncated")
+
+            game_index, length = GAME_HEADER.unpack(header)
+            data = f.read(length * 4)
+            if len(data) < length * 4:
+                raise ValueError(f"{path} is truncated")
+
+            records = array(RECORD_TYPECODE)
+            records.frombytes(data)
+            if sys.byteorder == "big":
+                records.byteswap()
+            yield game_index, records
+
+
+def to_hanab_live(deck: List[Card], records, num_players: int, names=None) -> dict:
+    """
+    Convert a game into the hanab.live JSON format. Cards in the deck may be
+    Card tuples or card codes, records any iterable of action records.
+    """
+
+    if names is None:
+        names = [f"Player {i}" for i in range(num_players)]
+
+    cards = [card if isinstance(card, tuple) else CARDS[card] for card in deck]
+    actions = []
+    for record in records:
+        action_type, _, target, value, _ = decode_action(record)
+        action = {"type": HANAB_LIVE_TYPES[action_type], "target": target}
+        if action_type not in (PLAY, DISCARD):
+            action["value"] = value
+        actions.append(action)
+
+    return {
+        "players": list(names),
+        "deck": [{"suitIndex": card.colour, "rank": card.rank} for card in cards],
+        "actions": actions,
+    }
+
+
+def dumps_hanab_live(deck: List[Card], records, num_players: int, names=None) -> str:
+    """JSON string of a game to import on hanab.live"""
+    return json.dumps(to_hanab_live(deck, records, num_players, names))
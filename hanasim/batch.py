@@ -0,0 +1,392 @@
+"""
+Batched hanasim engine that plays many games in lockstep.
+
+BatchBoard holds N games of the same player count as NumPy arrays and applies
+one resolve_move step to every live game at once. Cards are stored as the card
+codes of hanasim.card_code, hands as indices into the per-game decks. Hints
+cost a token and narrow the slot masks of the hinted hand like Board does.
+"""
+
+from abc import ABC, abstractmethod
+from typing import Tuple
+
+import numpy as np
+
+from hanasim.hanasim import (
+    ALL_CARDS_MASK,
+    Board,
+    CARDS,
+    COLOUR_MASKS,
+    COLOURS,
+    DISCARD,
+    FIVE,
+    END_NORMAL,
+    END_STRIKEOUT,
+    ENDGAME,
+    HANDSIZE,
+    HINTCOLOUR,
+    HINTRANK,
+    MAXRECORDS,
+    NUM_CARD_TYPES,
+    PLAY,
+    RANK_MASKS,
+    RANKS,
+    encode_action,
+)
+from hanasim.packed import CODECOUNTS, FIVES_MASK, ONES_MASK, RUN_MASKS
+from hanasim.seeding import DECK_CODES, game_decks
+
+# Arrays of per-game actions: action types, targets and values
+BatchAction = Tuple[np.ndarray, np.ndarray, np.ndarray]
+
+# Lookup tables indexed by card code
+CODE_BITS = np.left_shift(1, np.arange(NUM_CARD_TYPES, dtype=np.int64))
+CODE_COUNTS = np.array(CODECOUNTS, dtype=np.int8)
+CODE_COLOURS = np.array([card.colour for card in CARDS], dtype=np.int8)
+CODE_RANKS = np.array([card.rank for card in CARDS], dtype=np.int8)
+CODE_RUNS = np.array(RUN_MASKS, dtype=np.int64)
+
+# Card masks of the hint values, indexed by colour and by rank
+HINT_COLOUR_MASKS = np.array(COLOUR_MASKS, dtype=np.int64)
+HINT_RANK_MASKS = np.array([0] + [RANK_MASKS[r] for r in RANKS], dtype=np.int64)
+
+
+class AbstractBatchAgent(ABC):
+    """
+    AbstractBatchAgent defines the interface of a vectorized agent, which picks
+    the move of the current player in every game of a BatchBoard at once.
+    """
+
+    @abstractmethod
+    def find_moves(self, batch: "BatchBoard") -> BatchAction:
+        """Return action types, targets and values for all games"""
+
+
+class BatchBoard:
+    """
+    The batch board represents the state of N Hanabi games. Games that are
+    over are left untouched by resolve_moves.
+    """
+
+    MAXHINTS = Board.MAXHINTS
+    MAXSTRIKES = Board.MAXSTRIKES
+    NUMCARDS = Board.NUMCARDS
+
+    def __init__(
+        self, num_games: int, num_players: int, decks: np.ndarray = None
+    ) -> None:
+        """Constructor for the BatchBoard class"""
+
+        self.num_games = num_games
+        self.num_players = num_players
+        self.handsize = HANDSIZE[num_players]
+        self.decks = decks
+
+        # global game state
+        self.game_over = np.zeros(num_games, dtype=bool)
+        self.bonus_turns = np.full(num_games, num_players, dtype=np.int8)
+        self.num_hints = np.full(num_games, self.MAXHINTS, dtype=np.int8)
+        self.num_strikes = np.zeros(num_games, dtype=np.int8)
+        self.score = np.zeros(num_games, dtype=np.int8)
+        self.turn = np.zeros(num_games, dtype=np.int16)
+        self.index = np.zeros(num_games, dtype=np.int8)
+        self.fireworks = np.zeros((num_games, len(COLOURS)), dtype=np.int8)
+        self.discard_pile = np.zeros((num_games, NUM_CARD_TYPES), dtype=np.int8)
+        self.total_discarded = np.zeros(num_games, dtype=np.int8)
+
+        # hands hold deck indices, -1 marks an empty slot
+        shape = (num_games, num_players, self.handsize)
+        self.hands = np.full(shape, -1, dtype=np.int8)
+        self.hand_sizes = np.zeros((num_games, num_players), dtype=np.int8)
+
+        # cards each hand slot can still hold given the hints, 0 when empty
+        self.slot_masks = np.zeros(shape, dtype=np.int64)
+
+        # card sets as 25-bit masks
+        self.played = np.zeros(num_games, dtype=np.int64)
+        self.dead = np.zeros(num_games, dtype=np.int64)
+        self.useless = np.zeros(num_games, dtype=np.int64)
+        self.critical = np.full(num_games, FIVES_MASK, dtype=np.int64)
+        self.playable = np.full(num_games, ONES_MASK, dtype=np.int64)
+
+        # action logs of hanasim.encode_action records
+        self.logs = np.zeros((num_games, MAXRECORDS), dtype=np.uint32)
+        self.log_lengths = np.zeros(num_games, dtype=np.int16)
+
+    def generate_decks(self, rng: np.random.Generator = None) -> None:
+        """Generate a shuffled deck of Hanabi cards for every game"""
+
+        rng = rng if rng is not None else np.random.default_rng()
+        order = np.tile(np.arange(self.NUMCARDS), (self.num_games, 1))
+        self.decks = DECK_CODES[rng.permuted(order, axis=1)]
+
+    def seed_decks(self, seed: int, start: int = 0) -> None:
+        """Deal the decks of games start to start + num_games of a seeded sweep"""
+        self.decks = game_decks(seed, start, self.num_games)
+
+    def setup(self) -> None:
+        """Generate decks and deal cards"""
+
+        if self.decks is None:
+            self.generate_decks()
+        self.decks = np.asarray(self.decks, dtype=np.int8)
+        self._deal(slice(None))
+
+    def reset_games(self, rows: np.ndarray, decks: np.ndarray) -> None:
+        """Start new games with decks, one per row, e.g. in finished games"""
+
+        self.decks[rows] = decks
+        self.game_over[rows] = False
+        self.bonus_turns[rows] = self.num_players
+        self.num_hints[rows] = self.MAXHINTS
+        self.num_strikes[rows] = 0
+        self.score[rows] = 0
+        self.turn[rows] = 0
+        self.fireworks[rows] = 0
+        self.discard_pile[rows] = 0
+        self.total_discarded[rows] = 0
+        self.played[rows] = 0
+        self.dead[rows] = 0
+        self.useless[rows] = 0
+        self.critical[rows] = FIVES_MASK
+        self.playable[rows] = ONES_MASK
+        self.log_lengths[rows] = 0
+        self._deal(rows)
+
+    def _deal(self, rows) -> None:
+        """Deal cards to players, player by player as Board.deal does"""
+
+        dealt = self.num_players * self.handsize
+        self.hands[rows] = np.arange(dealt).reshape(self.num_players, self.handsize)
+        self.hand_sizes[rows] = self.handsize
+        self.slot_masks[rows] = ALL_CARDS_MASK
+        self.index[rows] = dealt
+
+    @property
+    def current_player(self) -> np.ndarray:
+        """Index of the player to move in every game"""
+        return self.turn % self.num_players
+
+    def hand_cards(self, player_ids: np.ndarray = None) -> np.ndarray:
+        """Card codes in the hand of a player per game, -1 for empty slots"""
+
+        if player_ids is None:
+            player_ids = self.current_player
+        rows = np.arange(self.num_games)
+        positions = self.hands[rows, player_ids]
+        cards = np.take_along_axis(self.decks, positions.astype(np.intp), axis=1)
+        return np.where(positions >= 0, cards, -1)
+
+    def resolve_moves(
+        self, action_types: np.ndarray, targets: np.ndarray, values: np.ndarray
+    ) -> None:
+        """Play out one move by the current player of every live game"""
+
+        action_types = np.asarray(action_types)
+        targets = np.asarray(targets)
+        values = np.asarray(values)
+
+        live = ~self.game_over
+        players = self.current_player
+        plays = live & (action_types == PLAY)
+        discards = live & (action_types == DISCARD)
+        hints = live & ((action_types == HINTCOLOUR) | (action_types == HINTRANK))
+
+        if np.any(live & ~(plays | discards | hints)):
+            raise ValueError("Invalid action type")
+        no_target = (targets == players) | (targets < 0) | (targets >= self.num_players)
+        if np.any(hints & (no_target | (self.num_hints == 0))):
+            raise ValueError("Invalid hint")
+
+        colour_hints = live & (action_types == HINTCOLOUR)
+        rank_hints = live & (action_types == HINTRANK)
+        valid_colours = (values >= 0) & (values < len(COLOURS))
+        valid_ranks = (values >= RANKS[0]) & (values <= RANKS[-1])
+        if np.any((colour_hints & ~valid_colours) | (rank_hints & ~valid_ranks)):
+            raise ValueError("Invalid hint value")
+
+        sizes = self.hand_sizes[np.arange(self.num_games), players]
+        if np.any((plays | discards) & ((targets < 0) | (targets >= sizes))):
+            raise ValueError("Invalid hand slot")
+
+        self.num_hints[hints] -= 1
+        self.num_hints[discards & (self.num_hints < self.MAXHINTS)] += 1
+        hinted = np.flatnonzero(hints)
+        self._hint(hinted, targets[hinted], colour_hints[hinted], values[hinted])
+
+        rows = np.flatnonzero(plays | discards)
+        positions, cards = self._remove(rows, players[rows], targets[rows])
+        self._draw(rows, players[rows])
+
+        is_play = plays[rows]
+        self._play(rows[is_play], cards[is_play], values[rows[is_play]])
+        self._discard(rows[~is_play], cards[~is_play])
+
+        # Log the moves, plays and discards target the deck index of the card
+        log_targets = np.where(hints, targets, 0).astype(np.int64)
+        log_targets[rows] = positions
+        records = encode_action(
+            action_types.astype(np.int64),
+            players.astype(np.int64),
+            log_targets,
+            np.where(discards, 0, values).astype(np.int64),
+            np.where(plays | discards, targets, 0).astype(np.int64),
+        )
+        self._log(np.flatnonzero(live), records[live])
+
+        strikeout = self.num_strikes == self.MAXSTRIKES
+        self.game_over |= live & strikeout
+
+        ended = np.flatnonzero(live & self.game_over)
+        reasons = np.where(strikeout[ended], END_STRIKEOUT, END_NORMAL)
+        ended_players = players[ended].astype(np.int64)
+        self._log(ended, encode_action(ENDGAME, ended_players, ended_players, reasons))
+
+        self.turn[live] += 1
+
+    def _log(self, rows: np.ndarray, records: np.ndarray) -> None:
+        """Append one record to the action log of every game in rows"""
+
+        self.logs[rows, self.log_lengths[rows]] = records
+        self.log_lengths[rows] += 1
+
+    def game_log(self, game: int) -> np.ndarray:
+        """Action records of a single game, without copying"""
+        return self.logs[game, : self.log_lengths[game]]
+
+    def _hint(
+        self,
+        rows: np.ndarray,
+        players: np.ndarray,
+        colours: np.ndarray,
+        values: np.ndarray,
+    ) -> None:
+        """Narrow the slot masks of hinted players, by colour or by rank"""
+
+        positions = self.hands[rows, players]
+        cards = self.decks[rows[:, None], np.maximum(positions, 0)]
+        matches = np.where(
+            colours[:, None],
+            CODE_COLOURS[cards] == values[:, None],
+            CODE_RANKS[cards] == values[:, None],
+        )
+        hinted = np.where(
+            colours,
+            HINT_COLOUR_MASKS[np.where(colours, values, 0)],
+            HINT_RANK_MASKS[np.where(colours, 0, values)],
+        )[:, None]
+
+        masks = self.slot_masks[rows, players]
+        masks &= np.where(matches, hinted, ~hinted)
+        masks[positions < 0] = 0
+        self.slot_masks[rows, players] = masks
+
+    def _remove(self, rows: np.ndarray, players: np.ndarray, slots: np.ndarray):
+        """Remove cards from hands, shifting the remaining cards left"""
+
+        positions = self.hands[rows, players, slots]
+        cards = self.decks[rows, positions]
+
+        hands = self.hands[rows, players]
+        masks = self.slot_masks[rows, players]
+        for slot in range(self.handsize - 1):
+            shift = slot >= slots
+            hands[shift, slot] = hands[shift, slot + 1]
+            masks[shift, slot] = masks[shift, slot + 1]
+        hands[:, -1] = -1
+        masks[:, -1] = 0
+        self.hands[rows, players] = hands
+        self.slot_masks[rows, players] = masks
+        self.hand_sizes[rows, players] -= 1
+
+        return positions, cards
+
+    def _draw(self, rows: np.ndarray, players: np.ndarray) -> None:
+        """Draw a card for players, or count down bonus turns"""
+
+        has_cards = self.index[rows] < self.NUMCARDS
+
+        empty = rows[~has_cards]
+        self.bonus_turns[empty] -= 1
+        self.game_over[empty] |= self.bonus_turns[empty] == 0
+
+        rows, players = rows[has_cards], players[has_cards]
+        self.hands[rows, players, self.hand_sizes[rows, players]] = self.index[rows]
+        self.slot_masks[rows, players, self.hand_sizes[rows, players]] = ALL_CARDS_MASK
+        self.hand_sizes[rows, players] += 1
+        self.index[rows] += 1
+
+    def _play(self, rows: np.ndarray, cards: np.ndarray, colours: np.ndarray):
+        """Play cards, issuing a strike for illegal ones"""
+
+        bits = CODE_BITS[cards]
+        legal = (CODE_COLOURS[cards] == colours) & (self.playable[rows] & bits != 0)
+
+        # If card is illegal, discard with strike
+        fail = rows[~legal]
+        self.num_strikes[fail] += 1
+        self._add_to_discard_pile(fail, cards[~legal])
+
+        # Play the card and make the next card of the firework playable
+        rows, cards, bits = rows[legal], cards[legal], bits[legal]
+        ranks = CODE_RANKS[cards]
+        self.fireworks[rows, CODE_COLOURS[cards]] += 1
+        self.played[rows] |= bits
+        self.useless[rows] |= bits
+        self.playable[rows] &= ~bits
+        self.playable[rows] |= np.where(ranks < FIVE, bits << 1, 0)
+        self.critical[rows] &= ~bits
+        self.score[rows] += 1
+        self.game_over[rows] |= self.score[rows] == len(COLOURS) * len(RANKS)
+
+        # A hint is obtained if the firework is completed
+        bonus = rows[(ranks == FIVE) & (self.num_hints[rows] < self.MAXHINTS)]
+        self.num_hints[bonus] += 1
+
+    def _discard(self, rows: np.ndarray, cards: np.ndarray) -> None:
+        """Discard cards"""
+
+        self._add_to_discard_pile(rows, cards)
+        self.total_discarded[rows] += 1
+
+    def _add_to_discard_pile(self, rows: np.ndarray, cards: np.ndarray) -> None:
+        """Move discarded or misplayed cards onto the discard piles"""
+
+        self.discard_pile[rows, cards] += 1
+
+        # copies of played or dead cards do not change critical and dead cards
+        bits = CODE_BITS[cards]
+        needed = self.useless[rows] & bits == 0
+        rows, cards, bits = rows[needed], cards[needed], bits[needed]
+
+        # account for critical and dead cards after discard
+        num_left = CODE_COUNTS[cards] - self.discard_pile[rows, cards]
+        self.critical[rows] |= np.where(num_left == 1, bits, 0)
+
+        dead = np.where(num_left == 0, CODE_RUNS[cards], 0)
+        self.critical[rows] &= ~dead
+        self.dead[rows] |= dead
+        self.useless[rows] |= dead
+
+    @property
+    def max_score(self) -> np.ndarray:
+        """Highest score still reachable per game given the dead cards"""
+
+        dead = self.dead.astype("<i8").view(np.uint8).reshape(-1, 8)
+        return NUM_CARD_TYPES - np.unpackbits(dead, axis=1).sum(axis=1, dtype=np.int16)
+
+    @property
+    def pace(self) -> np.ndarray:
+        """Number of discards left per game before max_score is out of reach"""
+
+        cards_left = self.NUMCARDS - self.index.astype(np.int16)
+        return self.score + cards_left + self.num_players - self.max_score
+
+
+def play_batch(batch: BatchBoard, agent: AbstractBatchAgent) -> np.ndarray:
+    """Play all games of a set up batch to the end and return the scores"""
+
+    while not batch.game_over.all():
+        batch.resolve_moves(*agent.find_moves(batch))
+
+    return batch.score
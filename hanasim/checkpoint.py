@@ -0,0 +1,142 @@
+"""
+Append-only checkpoints of long runs.
+
+A checkpoint is a file of JSON lines: a header with the run configuration,
+then one record per completed chunk holding the chunk, (start, stop, players,
+seed), and its aggregates from hanasim.stats. The aggregate of the whole run
+is the merge of its chunk aggregates, so it is not stored separately. A run
+writing action logs also records the size of its log file after each chunk,
+written to disk before the chunk is recorded.
+
+Reopening the checkpoint of an interrupted run with the same configuration
+loads the completed chunks. The restarted run merges their aggregates instead
+of playing them again and appends the chunks it plays. A last line torn by
+the crash is cut off before appending, and log_end is the log size of the
+last recorded chunk, to cut the log file back to.
+"""
+
+import json
+import os
+import time
+from typing import Any, Dict, Iterable, List, Tuple, Union
+
+from hanasim.stats import Moments, stats_from_dict
+
+Chunk = Tuple[int, int, int, int]
+ChunkStats = Union[Moments, List[Moments]]
+
+
+def encode_stats(stats: ChunkStats) -> Any:
+    """Aggregate, or list of aggregates, of a chunk as plain values"""
+
+    if isinstance(stats, list):
+        return [agent_stats.to_dict() for agent_stats in stats]
+    return stats.to_dict()
+
+
+def decode_stats(state: Any) -> ChunkStats:
+    if isinstance(state, list):
+        return [stats_from_dict(agent_state) for agent_state in state]
+    return stats_from_dict(state)
+
+
+class Checkpoint:
+    """
+    Record of the completed chunks of a run. Records are flushed as they are
+    written and synced to disk at most every sync_interval seconds.
+    """
+
+    def __init__(
+        self, path: str, config: Dict[str, Any], sync_interval: float = 1.0
+    ) -> None:
+        # Compare configurations as they read back from JSON
+        self.path = path
+        self.config = json.loads(json.dumps(config))
+        self.sync_interval = sync_interval
+        # Encoded aggregates, so callers may merge into the decoded ones
+        self.completed: Dict[Chunk, Any] = {}
+        self.log_end = 0
+
+        has_header = os.path.exists(path) and self._load()
+        self.file = open(path, "a")
+        if not has_header:
+            self._write({"config": self.config})
+        self.last_sync = time.perf_counter()
+
+    def _load(self) -> bool:
+        """Read the completed chunks, returning whether a header was found"""
+
+        with open(self.path, "rb") as f:
+            data = f.read()
+
+        header = None
+        end = 0
+        for line in data.splitlines(keepends=True):
+            try:
+                entry = json.loads(line) if line.endswith(b"\n") else None
+            except ValueError:
+                entry = None
+            if entry is None:
+                break
+            end += len(line)
+
+            if header is None:
+                header = entry.get("config")
+                if header != self.config:
+                    raise ValueError(
+                        f"{self.path} was written by a run with the "
+                        f"configuration {header}"
+                    )
+            else:
+                self.completed[tuple(entry["chunk"])] = entry["stats"]
+                self.log_end = entry.get("log_end", self.log_end)
+
+        if end < len(data):
+            os.truncate(self.path, end)
+        return header is not None
+
+    def _write(self, entry: Dict[str, Any]) -> None:
+        self.file.write(json.dumps(entry, separators=(",", ":")) + "\n")
+        self.file.flush()
+
+    def record(self, chunk: Chunk, stats: ChunkStats, log_end: int = None) -> None:
+        """
+        Append a completed chunk with its aggregates and, if given, the size
+        of the action log file with its logs
+        """
+
+        chunk = tuple(chunk)
+        self.completed[chunk] = encode_stats(stats)
+        entry = {"chunk": list(chunk), "stats": self.completed[chunk]}
+        if log_end is not None:
+            self.log_end = entry["log_end"] = log_end
+        self._write(entry)
+
+        now = time.perf_counter()
+        if now - self.last_sync >= self.sync_interval:
+            os.fsync(self.file.fileno())
+            self.last_sync = now
+
+    def pending(self, chunks: Iterable[Chunk]) -> List[Chunk]:
+        """Chunks that are not completed yet"""
+        return [chunk for chunk in chunks if tuple(chunk) not in self.completed]
+
+    def done(self, chunks: Iterable[Chunk]) -> List[Tuple[Chunk, ChunkStats]]:
+        """Completed chunks with their aggregates"""
+        return [
+            (tuple(chunk), decode_stats(self.completed[tuple(chunk)]))
+            for chunk in chunks
+            if tuple(chunk) in self.completed
+        ]
+
+    def close(self) -> None:
+        if not self.file.closed:
+            self.file.flush()
+            os.fsync(self.file.fileno())
+            self.file.close()
+
+    def __enter__(self) -> "Checkpoint":
+        return self
+
+    def __exit__(self, *exc) -> None:
+        self.close()
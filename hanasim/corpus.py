@@ -0,0 +1,73 @@
+"""
+Precomputed deck corpus files.
+
+A corpus stores shuffled decks as card codes, one byte per card and 50 bytes
+per deck, after a 16 byte header holding a magic string and the seed the decks
+were generated from. Deck i of a corpus generated with seed s is the deck of
+game i of a sweep seeded with s, see hanasim.seeding.
+
+To write a corpus of a million decks:
+
+    python -m hanasim.corpus decks.bin --count 1000000 --seed 0
+"""
+
+import argparse
+from typing import List
+
+import numpy as np
+
+from hanasim.hanasim import Board, CARDS, Card
+from hanasim.seeding import game_decks
+
+MAGIC = b"HNSDECK1"
+HEADER = np.dtype([("magic", "S8"), ("seed", "<i8")])
+DECKSIZE = Board.NUMCARDS
+
+
+def write_corpus(path: str, count: int, seed: int, block: int = 65536) -> None:
+    """Write the decks of games 0 to count of a seeded sweep to a file"""
+
+    header = np.array([(MAGIC, seed)], dtype=HEADER)
+    with open(path, "wb") as f:
+        f.write(header.tobytes())
+        for start in range(0, count, block):
+            decks = game_decks(seed, start, min(block, count - start))
+            f.write(decks.astype(np.uint8).tobytes())
+
+
+class DeckCorpus:
+    """Read-only, memory-mapped view of a deck corpus file"""
+
+    def __init__(self, path: str) -> None:
+        """Map a corpus file, raising ValueError if it is not a corpus"""
+
+        header = np.fromfile(path, dtype=HEADER, count=1)
+        if len(header) != 1 or header["magic"][0] != MAGIC:
+            raise ValueError(f"{path} is not a deck corpus")
+        self.seed = int(header["seed"][0])
+
+        data = np.memmap(path, dtype=np.uint8, mode="r", offset=HEADER.itemsize)
+        if len(data) % DECKSIZE:
+            raise ValueError(f"{path} is truncated")
+        self.decks = data.reshape(-1, DECKSIZE)
+
+    def __len__(self) -> int:
+        return len(self.decks)
+
+    def codes(self, start: int, stop: int) -> np.ndarray:
+        """Card codes of decks start to stop, one per row, without copying"""
+        return self.decks[start:stop]
+
+    def deck(self, index: int) -> List[Card]:
+        """Deck of a single game as a list of cards"""
+        return [CARDS[code] for code in self.decks[index].tolist()]
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="Write a deck corpus file")
+    parser.add_argument("path")
+    parser.add_argument("--count", type=int, required=True)
+    parser.add_argument("--seed", type=int, default=0)
+    args = parser.parse_args()
+
+    write_corpus(args.path, args.count, args.seed)
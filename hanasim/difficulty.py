@@ -0,0 +1,180 @@
+"""
+Per-deck difficulty index of a deck corpus.
+
+An index file stores one record per deck of a corpus for one player count,
+next to the corpus as decks.bin.5p.idx for 5 players, after a header holding
+the seed and number of decks of the corpus it was built from:
+
+    bound            upper bound on the score of cheating players
+    late_plays       plays of the bound that need the bonus turns
+    dealt_criticals  critical cards, the fives, dealt into the opening hands
+    min_pace         lowest pace of the bound's schedule, 0 is tightest
+    mean_pace        mean pace of the bound's schedule over the draws
+
+The bound relaxes the game to its timing alone: every play or discard draws
+one card, a card can be played from the action after its first copy is
+drawn, the ranks of a colour are played in order, one per action, and the
+players get one action per bonus turn after the last draw. No real game
+plays more cards than the relaxation, so a strategy's score over the bound
+says how much of a deck it used, and decks can be stratified by pace without
+replaying them. To index a corpus for every player count:
+
+    python -m hanasim.difficulty decks.bin --players 2 3 4 5
+"""
+
+import argparse
+from typing import List
+
+import numpy as np
+
+from hanasim.corpus import DECKSIZE, DeckCorpus
+from hanasim.hanasim import FIVE, HANDSIZE, NUM_CARD_TYPES, RANKS
+
+MAGIC = b"HNSDIDX2"
+HEADER = np.dtype(
+    [("magic", "S8"), ("seed", "<i8"), ("decks", "<i8"), ("players", "<i8")]
+)
+INDEX_DTYPE = np.dtype(
+    [
+        ("bound", np.uint8),
+        ("late_plays", np.uint8),
+        ("dealt_criticals", np.uint8),
+        ("min_pace", np.uint8),
+        ("mean_pace", np.float32),
+    ]
+)
+
+RANK_OFFSETS = np.arange(len(RANKS))
+CODE_OFFSETS = np.arange(NUM_CARD_TYPES)
+
+
+def index_path(corpus_path: str, num_players: int) -> str:
+    """Path of the index of a corpus for a player count"""
+    return f"{corpus_path}.{num_players}p.idx"
+
+
+def deck_difficulty(codes: List[int], num_players: int) -> tuple:
+    """Index record of one deck of card codes, see INDEX_DTYPE"""
+
+    dealt = num_players * HANDSIZE[num_players]
+    draws = DECKSIZE - dealt
+    horizon = draws + num_players
+
+    earliest = [DECKSIZE] * NUM_CARD_TYPES
+    for position in reversed(range(len(codes))):
+        earliest[codes[position]] = position
+
+    # First action each card can be played at, in rank order per colour
+    ready = []
+    for colour_start in range(0, NUM_CARD_TYPES, len(RANKS)):
+        previous = 0
+        for code in range(colour_start, colour_start + len(RANKS)):
+            drawn = max(earliest[code] - dealt + 1, 0)
+            previous = max(drawn + 1, previous + 1)
+            ready.append(previous)
+
+    # One play per action: the i-th play comes after the i-th ready card
+    times = []
+    for ready_at in sorted(ready):
+        times.append(max(ready_at, times[-1] + 1) if times else ready_at)
+    bound = sum(time <= horizon for time in times)
+    late_plays = sum(draws < time <= horizon for time in times)
+
+    paces = [
+        sum(time <= action for time in times) + draws - action + num_players - bound
+        for action in range(draws + 1)
+    ]
+    dealt_criticals = sum(code % len(RANKS) == FIVE - 1 for code in codes[:dealt])
+    return bound, late_plays, dealt_criticals, min(paces), sum(paces) / len(paces)
+
+
+def difficulty(decks: np.ndarray, num_players: int) -> np.ndarray:
+    """Index records of decks of card codes, one per row, see deck_difficulty"""
+
+    num_decks = len(decks)
+    dealt = num_players * HANDSIZE[num_players]
+    draws = DECKSIZE - dealt
+    horizon = draws + num_players
+    rows = np.arange(num_decks)
+
+    earliest = np.full((num_decks, NUM_CARD_TYPES), DECKSIZE)
+    for position in range(DECKSIZE - 1, -1, -1):
+        earliest[rows, decks[:, position]] = position
+
+    # ready = max(drawn + 1, previous + 1) is a running maximum of ready - rank
+    drawn = np.maximum(earliest - dealt + 1, 0) + 1
+    drawn = drawn.reshape(num_decks, -1, len(RANKS)) - RANK_OFFSETS
+    ready = np.maximum.accumulate(drawn, axis=2) + RANK_OFFSETS
+    ready = np.sort(ready.reshape(num_decks, -1), axis=1)
+    times = np.maximum.accumulate(ready - CODE_OFFSETS, axis=1) + CODE_OFFSETS
+
+    records = np.zeros(num_decks, dtype=INDEX_DTYPE)
+    bound = (times <= horizon).sum(axis=1)
+    records["bound"] = bound
+    records["late_plays"] = ((times > draws) & (times <= horizon)).sum(axis=1)
+    records["dealt_criticals"] = (decks[:, :dealt] % len(RANKS) == FIVE - 1).sum(axis=1)
+
+    actions = np.arange(draws + 1)
+    plays = (times[:, :, None] <= actions).sum(axis=1)
+    paces = plays + (draws + num_players - actions) - bound[:, None]
+    records["min_pace"] = paces.min(axis=1)
+    records["mean_pace"] = paces.mean(axis=1)
+    return records
+
+
+def write_index(corpus_path: str, num_players: int, block: int = 65536) -> str:
+    """Index every deck of a corpus for a player count, returning its path"""
+
+    corpus = DeckCorpus(corpus_path)
+    path = index_path(corpus_path, num_players)
+    header = np.array([(MAGIC, corpus.seed, len(corpus), num_players)], dtype=HEADER)
+    with open(path, "wb") as f:
+        f.write(header.tobytes())
+        for start in range(0, len(corpus), block):
+            decks = corpus.codes(start, start + block).astype(np.intp)
+            f.write(difficulty(decks, num_players).tobytes())
+    return path
+
+
+class DeckIndex:
+    """Read-only, memory-mapped view of a difficulty index file"""
+
+    def __init__(self, path: str, corpus: DeckCorpus = None) -> None:
+        """
+        Map an index file, raising ValueError if it is not an index or, given
+        the corpus it should index, was built from another corpus
+        """
+
+        header = np.fromfile(path, dtype=HEADER, count=1)
+        if len(header) != 1 or header["magic"][0] != MAGIC:
+            raise ValueError(f"{path} is not a deck index")
+        self.seed = int(header["seed"][0])
+        self.num_decks = int(header["decks"][0])
+        self.num_players = int(header["players"][0])
+
+        data = np.memmap(path, dtype=np.uint8, mode="r", offset=HEADER.itemsize)
+        if len(data) != self.num_decks * INDEX_DTYPE.itemsize:
+            raise ValueError(f"{path} is truncated")
+        self.records = data.view(INDEX_DTYPE)
+
+        if corpus is not None and (corpus.seed, len(corpus)) != (
+            self.seed,
+            self.num_decks,
+        ):
+            raise ValueError(
+                f"{path} indexes {self.num_decks} decks of seed {self.seed}, "
+                f"not the {len(corpus)} decks of seed {corpus.seed} of the corpus"
+            )
+
+    def __len__(self) -> int:
+        return len(self.records)
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="Index the decks of a corpus")
+    parser.add_argument("corpus")
+    parser.add_argument("--players", type=int, nargs="+", default=[5])
+    args = parser.parse_args()
+
+    for num_players in args.players:
+        print(write_index(args.corpus, num_players))
@@ -0,0 +1,263 @@
+"""
+Exact endgame search for cheating agents.
+
+Once the deck is empty no more cards are drawn, every play or discard uses up
+one of the bonus turns and the rest of the game only depends on the cards in
+the hands, the fireworks, the hint tokens, the bonus turns left and the
+player to move. EndgameSolver searches these final turns exhaustively with
+every hand visible, giving the best final score the players can still reach,
+e.g. as an upper bound on what a strategy could have made of its endgame.
+
+Positions are keyed by Zobrist hashes over the hand multisets, fireworks,
+hint tokens, strikes, bonus turns and the player to move, updated
+incrementally with every move. The transposition table only depends on the
+player count, so one solver serves every endgame of a sweep. Misplays are not
+searched: discarding the same card instead reaches the same position with
+one strike less and at least as many hint tokens. Hints only spend a token,
+so one hint stands for all of them.
+"""
+
+import random
+from typing import Dict, List, Tuple
+
+from hanasim.hanasim import (
+    Action,
+    Board,
+    CARDS,
+    COLOURS,
+    DISCARD,
+    FIVE,
+    HINTRANK,
+    NUM_CARD_TYPES,
+    ONE,
+    PLAY,
+    card_code,
+)
+
+MAXSCORE = 25
+MAXCOPIES = 3
+
+# Moves of the search, the card code played or discarded or HINT
+Move = Tuple[int, bool]
+HINT = (-1, False)
+
+CODE_COLOURS = [card.colour for card in CARDS]
+CODE_RANKS = [card.rank for card in CARDS]
+
+
+class EndgameSolver:
+    """
+    Solver of the endgames of num_players player games, keeping its
+    transposition table of positions and their best final score
+    """
+
+    def __init__(self, num_players: int, seed: int = 0) -> None:
+        self.num_players = num_players
+        rng = random.Random(seed)
+
+        def keys(n):
+            return [rng.getrandbits(64) for _ in range(n)]
+
+        # One key per (player, card code, copy) held, firework height, etc.
+        self.hand_keys = [
+            [keys(MAXCOPIES) for _ in range(NUM_CARD_TYPES)]
+            for _ in range(num_players)
+        ]
+        self.firework_keys = [keys(FIVE + 1) for _ in COLOURS]
+        self.hint_keys = keys(Board.MAXHINTS + 1)
+        self.strike_keys = keys(Board.MAXSTRIKES + 1)
+        self.bonus_keys = keys(num_players + 1)
+        self.player_keys = keys(num_players)
+
+        self.table: Dict[int, int] = {}
+        self.nodes = 0
+
+        # Position being searched, set by load
+        self.counts: List[List[int]] = []
+        self.totals: List[int] = []
+        self.fireworks: List[int] = []
+        self.num_hints = 0
+        self.num_strikes = 0
+        self.bonus_turns = 0
+        self.player = 0
+        self.score = 0
+
+    def load(self, game: Board) -> int:
+        """Copy an endgame into the solver, returning its key"""
+
+        if game.num_players != self.num_players:
+            raise ValueError(
+                f"Solver for {self.num_players} players, not {game.num_players}"
+            )
+        if game.index < len(game.deck):
+            raise ValueError("The deck is not empty yet")
+
+        deck = game.deck
+        self.counts = [[0] * NUM_CARD_TYPES for _ in range(self.num_players)]
+        for counts, hand in zip(self.counts, game.player_hands):
+            for position in hand:
+                counts[card_code(deck[position])] += 1
+        self.totals = [sum(column) for column in zip(*self.counts)]
+        self.fireworks = list(game.fireworks)
+        self.num_hints = game.num_hints
+        self.num_strikes = game.num_strikes
+        self.bonus_turns = game.bonus_turns
+        self.player = game.turn % self.num_players
+        self.score = game.score
+
+        key = (
+            self.hint_keys[self.num_hints]
+            ^ self.strike_keys[self.num_strikes]
+            ^ self.bonus_keys[self.bonus_turns]
+            ^ self.player_keys[self.player]
+        )
+        for colour, height in enumerate(self.fireworks):
+            key ^= self.firework_keys[colour][height]
+        for player_keys, counts in zip(self.hand_keys, self.counts):
+            for code, count in enumerate(counts):
+                for copy in range(count):
+                    key ^= player_keys[code][copy]
+        return key
+
+    def bound(self) -> int:
+        """
+        Final score if every card still in a hand that extends a firework
+        could be played, within the bonus turns left
+        """
+
+        extension = 0
+        totals = self.totals
+        for colour, height in enumerate(self.fireworks):
+            code = colour * FIVE + height
+            while height < FIVE and totals[code]:
+                height += 1
+                code += 1
+                extension += 1
+        return self.score + min(extension, self.bonus_turns)
+
+    def moves(self) -> List[Move]:
+        """
+        Moves of the player to move, plays first as they are most often best.
+        Playable cards may also be discarded, after the others.
+        """
+
+        plays, discards = [], []
+        for code, count in enumerate(self.counts[self.player]):
+            if count:
+                if CODE_RANKS[code] == self.fireworks[CODE_COLOURS[code]] + 1:
+                    plays.append((code, False))
+                else:
+                    discards.append((code, True))
+
+        moves = plays + discards + [(code, True) for code, _ in plays]
+        if self.num_hints:
+            moves.append(HINT)
+        return moves
+
+    def search(self, key: int) -> int:
+        """Best final score of the loaded position with key"""
+
+        if self.score == MAXSCORE or self.bonus_turns == 0:
+            return self.score
+        value = self.table.get(key)
+        if value is not None:
+            return value
+
+        self.nodes += 1
+        bound = self.bound()
+
+        # A player without cards or hint tokens cannot move and ends the game
+        best = self.score
+        for move in self.moves():
+            value = self.move_value(key, move)
+            if value > best:
+                best = value
+                if best == bound:
+                    break
+
+        self.table[key] = best
+        return best
+
+    def move_value(self, key: int, move: Move) -> int:
+        """Best final score after a move of the player to move"""
+
+        code, discard = move
+        player = self.player
+        next_player = (player + 1) % self.num_players
+        num_hints = self.num_hints
+        key ^= self.player_keys[player] ^ self.player_keys[next_player]
+        self.player = next_player
+
+        if code == HINT[0]:
+            key ^= self.hint_keys[num_hints] ^ self.hint_keys[num_hints - 1]
+            self.num_hints = num_hints - 1
+            value = self.search(key)
+            self.num_hints = num_hints
+            self.player = player
+            return value
+
+        # Remove the card and use up a bonus turn
+        counts = self.counts[player]
+        counts[code] -= 1
+        self.totals[code] -= 1
+        key ^= self.hand_keys[player][code][counts[code]]
+        bonus_keys = self.bonus_keys
+        key ^= bonus_keys[self.bonus_turns] ^ bonus_keys[self.bonus_turns - 1]
+        self.bonus_turns -= 1
+
+        colour = CODE_COLOURS[code]
+        gains_hint = num_hints < Board.MAXHINTS
+        if discard:
+            new_hints = num_hints + gains_hint
+        else:
+            height = self.fireworks[colour]
+            firework_keys = self.firework_keys[colour]
+            key ^= firework_keys[height] ^ firework_keys[height + 1]
+            self.fireworks[colour] = height + 1
+            self.score += 1
+            new_hints = num_hints + (gains_hint and height + 1 == FIVE)
+        key ^= self.hint_keys[num_hints] ^ self.hint_keys[new_hints]
+        self.num_hints = new_hints
+
+        value = self.search(key)
+
+        if not discard:
+            self.fireworks[colour] -= 1
+            self.score -= 1
+        self.num_hints = num_hints
+        self.bonus_turns += 1
+        counts[code] += 1
+        self.totals[code] += 1
+        self.player = player
+        return value
+
+    def solve(self, game: Board) -> int:
+        """Best final score the players can reach from an endgame"""
+
+        if game.game_over:
+            return game.score
+        return self.search(self.load(game))
+
+    def best_move(self, game: Board) -> Action:
+        """Move of the player to move that reaches the best final score"""
+
+        if game.game_over:
+            raise ValueError("The game is over")
+        key = self.load(game)
+        player = self.player
+        moves = self.moves()
+        if not moves:
+            raise ValueError(f"Player {player} cannot move")
+        values = [self.move_value(key, move) for move in moves]
+        code, discard = moves[values.index(max(values))]
+
+        if (code, discard) == HINT:
+            return (HINTRANK, (player + 1) % self.num_players, ONE)
+        slot = next(
+            slot
+            for slot, position in enumerate(game.player_hands[player])
+            if card_code(game.deck[position]) == code
+        )
+        if discard:
+            return (DISCARD, slot, 0)
+        return (PLAY, slot, CODE_COLOURS[code])
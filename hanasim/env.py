@@ -0,0 +1,479 @@
+"""
+Vectorized environments for reinforcement learning.
+
+The environments step many games at once with indices of the fixed action
+space of hanasim.ACTION_MOVES and follow the vectorized Gym API:
+
+    observations, info = env.reset()
+    observations, rewards, terminated, truncated, info = env.step(actions)
+
+Observations are those of the player to move, laid out by
+hanasim.observation.ObservationEncoder. info holds the legal action masks,
+the player to move and the final score of the games that ended in the step.
+Finished games are reset right away, so the returned observation of a
+terminated game is the first of the next one. The reward is the team's
+score gain of the move.
+
+VectorEnv steps a list of Boards and BatchVectorEnv a single BatchBoard. They
+play the same games for the same seed: game k of environment i uses the
+deck of game first + i + k * stride of the seeded sweep.
+AsyncVectorEnv splits the games over worker processes, which step their
+share straight into observation, action and result buffers in shared memory.
+The arrays it returns are views of those buffers, valid until the next step.
+"""
+
+import multiprocessing
+import traceback
+from multiprocessing import shared_memory
+from typing import Dict, List, Tuple
+
+import numpy as np
+
+from hanasim.batch import CODE_COLOURS, BatchBoard
+from hanasim.hanasim import ACTION_MOVES, HINTCOLOUR, HINTRANK, LEGAL_MASKS, PLAY
+from hanasim.observation import ObservationEncoder
+from hanasim.packed import PackedBoard
+from hanasim.seeding import game_deck, game_decks
+
+Buffers = Dict[str, np.ndarray]
+StepResult = Tuple[np.ndarray, np.ndarray, np.ndarray, np.ndarray, Buffers]
+
+
+def buffer_specs(
+    num_envs: int, num_players: int, dtype=np.uint8
+) -> List[Tuple[str, tuple, np.dtype]]:
+    """Names, shapes and types of the buffers of an environment"""
+
+    size = ObservationEncoder(num_players).size
+    num_actions = len(ACTION_MOVES[num_players])
+    return [
+        ("observations", (num_envs, size), np.dtype(dtype)),
+        ("legal", (num_envs, num_actions), np.dtype(bool)),
+        ("actions", (num_envs,), np.dtype(np.int64)),
+        ("rewards", (num_envs,), np.dtype(np.float32)),
+        ("terminated", (num_envs,), np.dtype(bool)),
+        ("truncated", (num_envs,), np.dtype(bool)),
+        ("player", (num_envs,), np.dtype(np.int64)),
+        ("final_score", (num_envs,), np.dtype(np.int64)),
+    ]
+
+
+def allocate(specs) -> Buffers:
+    return {name: np.zeros(shape, dtype) for name, shape, dtype in specs}
+
+
+class SharedBuffers:
+    """
+    Buffers of buffer_specs laid out in one shared memory block. The creating
+    process unlinks the block when done, workers attach to it by name.
+    """
+
+    def __init__(self, shm: shared_memory.SharedMemory, specs) -> None:
+        """Wrap an existing shared memory block, use create or attach instead"""
+
+        self.shm = shm
+        self.specs = specs
+        self.arrays: Buffers = {}
+        offset = 0
+        for name, shape, dtype in specs:
+            array = np.ndarray(shape, dtype, buffer=shm.buf, offset=offset)
+            self.arrays[name] = array
+            offset = -(-(offset + array.nbytes) // 8) * 8
+
+    @staticmethod
+    def nbytes(specs) -> int:
+        total = 0
+        for _, shape, dtype in specs:
+            total = -(-(total + int(np.prod(shape)) * dtype.itemsize) // 8) * 8
+        return max(total, 1)
+
+    @classmethod
+    def create(cls, specs) -> "SharedBuffers":
+        """Allocate a zeroed block for the buffers"""
+
+        size = cls.nbytes(specs)
+        shared = cls(shared_memory.SharedMemory(create=True, size=size), specs)
+        for array in shared.arrays.values():
+            array[...] = 0
+        return shared
+
+    @classmethod
+    def attach(cls, name: str, specs) -> "SharedBuffers":
+        """Attach to a block created by another process"""
+        return cls(shared_memory.SharedMemory(name=name), specs)
+
+    @property
+    def name(self) -> str:
+        return self.shm.name
+
+    def close(self) -> None:
+        """Release this process' view of the block"""
+
+        self.arrays = {}
+        try:
+            self.shm.close()
+        except BufferError:
+            # Arrays handed out are still referenced, the mapping dies with them
+            pass
+
+    def unlink(self) -> None:
+        self.shm.unlink()
+
+
+class BaseVectorEnv:
+    """Buffers, observation encoder and info shared by the environments"""
+
+    def __init__(
+        self,
+        num_envs: int,
+        num_players: int,
+        seed: int,
+        dtype,
+        first: int,
+        stride: int,
+        buffers: Buffers,
+    ) -> None:
+        self.num_envs = num_envs
+        self.num_players = num_players
+        self.seed = seed
+        self.first = first
+        self.stride = stride if stride is not None else num_envs
+        self.encoder = ObservationEncoder(num_players)
+        self.num_actions = len(ACTION_MOVES[num_players])
+        self.action_shifts = np.arange(self.num_actions, dtype=np.int64)
+        self.episodes = np.zeros(num_envs, dtype=np.int64)
+
+        if buffers is None:
+            buffers = allocate(buffer_specs(num_envs, num_players, dtype))
+        self.buffers = buffers
+        self.observations = buffers["observations"]
+        self.legal = buffers["legal"]
+
+    def _info(self) -> Buffers:
+        buffers = self.buffers
+        return {
+            "legal": buffers["legal"],
+            "player": buffers["player"],
+            "final_score": buffers["final_score"],
+        }
+
+    def _results(self) -> StepResult:
+        buffers = self.buffers
+        return (
+            buffers["observations"],
+            buffers["rewards"],
+            buffers["terminated"],
+            buffers["truncated"],
+            self._info(),
+        )
+
+    def close(self) -> None:
+        """Release the environments"""
+
+
+class VectorEnv(BaseVectorEnv):
+    """num_envs Boards of board_class stepped one after another"""
+
+    def __init__(
+        self,
+        num_envs: int,
+        num_players: int,
+        seed: int = 0,
+        board_class=PackedBoard,
+        dtype=np.uint8,
+        first: int = 0,
+        stride: int = None,
+        buffers: Buffers = None,
+    ) -> None:
+        super().__init__(num_envs, num_players, seed, dtype, first, stride, buffers)
+        self.games = [board_class(num_players) for _ in range(num_envs)]
+
+    def _new_game(self, env: int) -> None:
+        game = self.games[env]
+        index = self.first + env + int(self.episodes[env]) * self.stride
+        game.reset(game_deck(self.seed, index))
+        game.setup()
+        self.episodes[env] += 1
+
+    def _observe(self, env: int) -> None:
+        """Observation and legal actions of the player to move"""
+
+        game = self.games[env]
+        player_id = game.turn % self.num_players
+        self.encoder.encode(game, player_id, self.observations[env])
+        self.legal[env] = (game.legal_actions(player_id) >> self.action_shifts) & 1
+        self.buffers["player"][env] = player_id
+
+    def reset(self) -> Tuple[np.ndarray, Buffers]:
+        """Start new games in every environment"""
+
+        self.episodes[:] = 0
+        self.buffers["final_score"][:] = 0
+        for env in range(self.num_envs):
+            self._new_game(env)
+            self._observe(env)
+        return self.observations, self._info()
+
+    def step(self, actions: np.ndarray) -> StepResult:
+        """
+        Play one action index per environment for its player to move. Raises
+        ValueError on an illegal action, before stepping any environment.
+        """
+
+        rewards = self.buffers["rewards"]
+        terminated = self.buffers["terminated"]
+        final_score = self.buffers["final_score"]
+        final_score[:] = 0
+
+        actions = np.asarray(actions).tolist()
+        for env, action in enumerate(actions):
+            game = self.games[env]
+            player_id = game.turn % self.num_players
+            if not 0 <= action < self.num_actions or not game.is_legal(
+                player_id, action
+            ):
+                raise ValueError(f"Illegal action {action} in environment {env}")
+
+        for env, action in enumerate(actions):
+            game = self.games[env]
+            player_id = game.turn % self.num_players
+            score = game.score
+            game.resolve_move(player_id, game.action_to_move(player_id, action))
+            rewards[env] = game.score - score
+            terminated[env] = game.game_over
+            if game.game_over:
+                final_score[env] = game.score
+                self._new_game(env)
+            self._observe(env)
+
+        return self._results()
+
+
+class BatchVectorEnv(BaseVectorEnv):
+    """num_envs games on one BatchBoard, stepped in lockstep"""
+
+    def __init__(
+        self,
+        num_envs: int,
+        num_players: int,
+        seed: int = 0,
+        dtype=np.uint8,
+        first: int = 0,
+        stride: int = None,
+        buffers: Buffers = None,
+    ) -> None:
+        super().__init__(num_envs, num_players, seed, dtype, first, stride, buffers)
+        decks = np.zeros((num_envs, BatchBoard.NUMCARDS), dtype=np.int8)
+        self.batch = BatchBoard(num_envs, num_players, decks)
+        self.rows = np.arange(num_envs)
+
+        # Action space as arrays, and the legal masks by hand size and hints
+        moves = np.array(ACTION_MOVES[num_players], dtype=np.int64)
+        self.move_types, self.move_targets, self.move_values = moves.T
+        masks = np.array(LEGAL_MASKS[num_players], dtype=np.int64)
+        self.legal_table = ((masks[..., None] >> self.action_shifts) & 1) == 1
+
+    def _decks(self, rows: np.ndarray) -> np.ndarray:
+        """Decks of the next games of rows"""
+
+        indices = self.first + rows + self.episodes[rows] * self.stride
+        self.episodes[rows] += 1
+        return np.concatenate(
+            [game_decks(self.seed, index, 1) for index in indices.tolist()]
+        )
+
+    def _observe(self) -> None:
+        """Observations and legal actions of the players to move"""
+
+        batch = self.batch
+        players = batch.current_player
+        self.encoder.encode_batch(batch, players, self.observations)
+        sizes = batch.hand_sizes[self.rows, players]
+        self.legal[:] = self.legal_table[sizes, (batch.num_hints > 0).astype(int)]
+        self.buffers["player"][:] = players
+
+    def reset(self) -> Tuple[np.ndarray, Buffers]:
+        """Start new games in every environment"""
+
+        self.episodes[:] = 0
+        self.buffers["final_score"][:] = 0
+        self.batch.reset_games(self.rows, self._decks(self.rows))
+        self._observe()
+        return self.observations, self._info()
+
+    def step(self, actions: np.ndarray) -> StepResult:
+        """
+        Play one action index per environment for its player to move. Raises
+        ValueError on an illegal action.
+        """
+
+        batch = self.batch
+        actions = np.asarray(actions, dtype=np.int64)
+        if np.any((actions < 0) | (actions >= self.num_actions)):
+            raise ValueError("Action out of the action space")
+        if not np.all(self.legal[self.rows, actions]):
+            raise ValueError("Illegal action")
+
+        # Cards are played onto their own firework, hints target by offset
+        players = batch.current_player
+        action_types = self.move_types[actions]
+        targets = self.move_targets[actions]
+        plays = action_types == PLAY
+        slots = np.where(plays, targets, 0)
+        colours = CODE_COLOURS[np.maximum(batch.hand_cards(players), 0)]
+        values = np.where(plays, colours[self.rows, slots], self.move_values[actions])
+        hints = (action_types == HINTCOLOUR) | (action_types == HINTRANK)
+        targets = np.where(hints, (players + targets) % self.num_players, targets)
+
+        score = batch.score.astype(np.int64)
+        batch.resolve_moves(action_types, targets, values)
+        self.buffers["rewards"][:] = batch.score - score
+        self.buffers["terminated"][:] = batch.game_over
+        self.buffers["final_score"][:] = np.where(batch.game_over, batch.score, 0)
+
+        finished = np.flatnonzero(batch.game_over)
+        if len(finished):
+            batch.reset_games(finished, self._decks(finished))
+        self._observe()
+
+        return self._results()
+
+
+def _worker(connection, buffers_name, specs, start, stop, env_class, kwargs) -> None:
+    """Step the environments start to stop of an AsyncVectorEnv"""
+
+    shared = SharedBuffers.attach(buffers_name, specs)
+    try:
+        buffers = {name: array[start:stop] for name, array in shared.arrays.items()}
+        env = env_class(stop - start, first=start, buffers=buffers, **kwargs)
+        while True:
+            command = connection.recv()
+            if command == "close":
+                break
+            try:
+                if command == "reset":
+                    env.reset()
+                else:
+                    env.step(buffers["actions"])
+                connection.send(None)
+            except Exception:
+                connection.send(traceback.format_exc())
+    finally:
+        buffers = env = None
+        shared.close()
+        connection.close()
+
+
+class AsyncVectorEnv:
+    """
+    VectorEnv, or BatchVectorEnv with env_class, whose environments are
+    split over num_workers processes. step_async and step_wait let the
+    caller work while the workers step.
+    """
+
+    def __init__(
+        self,
+        num_envs: int,
+        num_players: int,
+        num_workers: int = None,
+        seed: int = 0,
+        env_class=VectorEnv,
+        dtype=np.uint8,
+        **kwargs,
+    ) -> None:
+        num_workers = num_workers or multiprocessing.cpu_count()
+        num_workers = max(1, min(num_workers, num_envs))
+        self.num_envs = num_envs
+        self.num_players = num_players
+
+        specs = buffer_specs(num_envs, num_players, dtype)
+        self.shared = SharedBuffers.create(specs)
+        self.buffers = self.shared.arrays
+        kwargs = dict(kwargs, num_players=num_players, seed=seed, dtype=dtype)
+        kwargs["stride"] = num_envs
+
+        bounds = np.linspace(0, num_envs, num_workers + 1).astype(int).tolist()
+        self.connections = []
+        self.workers = []
+        for start, stop in zip(bounds, bounds[1:]):
+            parent, child = multiprocessing.Pipe()
+            worker = multiprocessing.Process(
+                target=_worker,
+                args=(child, self.shared.name, specs, start, stop, env_class, kwargs),
+                daemon=True,
+            )
+            worker.start()
+            child.close()
+            self.connections.append(parent)
+            self.workers.append(worker)
+        self.waiting = False
+
+    def _send(self, command: str) -> None:
+        for connection in self.connections:
+            connection.send(command)
+        self.waiting = True
+
+    def _wait(self) -> None:
+        errors = [connection.recv() for connection in self.connections]
+        self.waiting = False
+        errors = [error for error in errors if error is not None]
+        if errors:
+            raise RuntimeError(f"Environment worker failed:\n{errors[0]}")
+
+    _info = BaseVectorEnv._info
+    _results = BaseVectorEnv._results
+
+    def reset(self) -> Tuple[np.ndarray, Buffers]:
+        """Start new games in every environment"""
+
+        self._send("reset")
+        self._wait()
+        return self.buffers["observations"], self._info()
+
+    def step_async(self, actions: np.ndarray) -> None:
+        """
+        Hand the actions to the workers without waiting for them. Raises
+        ValueError on an illegal action, before any worker steps.
+        """
+
+        legal = self.buffers["legal"]
+        actions = np.asarray(actions, dtype=np.int64)
+        if np.any((actions < 0) | (actions >= legal.shape[1])):
+            raise ValueError("Action out of the action space")
+        if not np.all(legal[np.arange(self.num_envs), actions]):
+            raise ValueError("Illegal action")
+
+        self.buffers["actions"][:] = actions
+        self._send("step")
+
+    def step_wait(self) -> StepResult:
+        """Results of the step started by step_async"""
+
+        self._wait()
+        return self._results()
+
+    def step(self, actions: np.ndarray) -> StepResult:
+        self.step_async(actions)
+        return self.step_wait()
+
+    def close(self) -> None:
+        """Stop the workers and free the shared buffers"""
+
+        if self.waiting:
+            self._wait()
+        for connection in self.connections:
+            connection.send("close")
+        for worker in self.workers:
+            worker.join()
+        for connection in self.connections:
+            connection.close()
+        self.connections = []
+        self.buffers = None
+        self.shared.close()
+        self.shared.unlink()
+
+    def __enter__(self) -> "AsyncVectorEnv":
+        return self
+
+    def __exit__(self, *exc) -> None:
+        self.close()
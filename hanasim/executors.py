@@ -0,0 +1,309 @@
+"""
+Executors that play the chunks of a run, on one machine or on a cluster.
+
+An executor runs an initializer with its arguments once in every worker
+process and maps a task function over chunks with imap_unordered, like
+multiprocessing.Pool. Task functions and their arguments travel pickled by
+reference, so every node needs the same checkout of the code and of deck
+corpus files. Chunks are seeded by game index, so every executor gives the
+same aggregates, and action logs when collected, for the same seeds.
+
+    serial  plays in the driver process, for debugging and profiling
+    local   multiprocessing.Pool on this machine
+    socket  workers started with python -m hanasim.executors HOST:PORT
+    ray     tasks on a Ray cluster, needs ray
+    dask    tasks on a Dask cluster, needs dask.distributed
+
+The socket executor sends pickles, which can run arbitrary code, so the
+driver and its workers share the secret key in HANASIM_AUTHKEY.
+"""
+
+import argparse
+import multiprocessing
+import os
+import traceback
+import uuid
+from multiprocessing.connection import Client, Listener, wait
+from typing import Any, Callable, Iterable, Iterator, Optional, Tuple
+
+AUTHKEY_VARIABLE = "HANASIM_AUTHKEY"
+
+# Token of the setup last run by initialized_call in this process
+_setup_token = None
+
+
+def initialized_call(setup: tuple, func: Callable, task: Any) -> Any:
+    """
+    Run func on a task in a process set up with the initializer of setup,
+    which is run on the first task of an executor in each process.
+    """
+
+    global _setup_token
+    token, initializer, initargs = setup
+    if token != _setup_token:
+        if initializer is not None:
+            initializer(*initargs)
+        _setup_token = token
+    return func(task)
+
+
+def parse_address(address: str) -> Tuple[str, int]:
+    """Host and port of a HOST:PORT address"""
+
+    host, _, port = address.rpartition(":")
+    if not host or not port.isdigit():
+        raise ValueError(f"Invalid address {address!r}, expected HOST:PORT")
+    return host, int(port)
+
+
+def get_authkey() -> bytes:
+    authkey = os.environ.get(AUTHKEY_VARIABLE)
+    if not authkey:
+        raise ValueError(f"Set {AUTHKEY_VARIABLE} to the secret key of the workers")
+    return authkey.encode()
+
+
+class Executor:
+    """Base class of the executors, which close when leaving a with block"""
+
+    def imap_unordered(self, func: Callable, iterable: Iterable) -> Iterator:
+        raise NotImplementedError
+
+    def close(self) -> None:
+        """Release the workers"""
+
+    def __enter__(self) -> "Executor":
+        return self
+
+    def __exit__(self, *exc) -> None:
+        self.close()
+
+
+class SerialExecutor(Executor):
+    """Plays the tasks one by one in the calling process"""
+
+    def __init__(self, initializer: Callable = None, initargs: tuple = ()) -> None:
+        if initializer is not None:
+            initializer(*initargs)
+
+    def imap_unordered(self, func: Callable, iterable: Iterable) -> Iterator:
+        return map(func, iterable)
+
+
+class LocalExecutor(Executor):
+    """Pool of worker processes on this machine"""
+
+    def __init__(
+        self,
+        initializer: Callable = None,
+        initargs: tuple = (),
+        processes: Optional[int] = None,
+    ) -> None:
+        self.pool = multiprocessing.Pool(processes, initializer, initargs)
+
+    def imap_unordered(self, func: Callable, iterable: Iterable) -> Iterator:
+        return self.pool.imap_unordered(func, iterable)
+
+    def close(self) -> None:
+        self.pool.close()
+        self.pool.join()
+
+    def __exit__(self, exc_type, *exc) -> None:
+        if exc_type is not None:
+            self.pool.terminate()
+        self.close()
+
+
+class SocketExecutor(Executor):
+    """
+    Listens on address for processes workers to connect, then hands each
+    worker one task at a time. Workers are set up with the initializer when
+    they connect and run until the executor closes.
+    """
+
+    def __init__(
+        self,
+        initializer: Callable = None,
+        initargs: tuple = (),
+        address: Tuple[str, int] = ("localhost", 0),
+        processes: int = 1,
+        authkey: bytes = None,
+    ) -> None:
+        if processes < 1:
+            raise ValueError("The socket executor needs at least one worker")
+
+        authkey = authkey if authkey is not None else get_authkey()
+        self.listener = Listener(address, authkey=authkey)
+        self.address = self.listener.address
+        self.setup = (initializer, initargs)
+        self.processes = processes
+        self.connections = []
+
+    def connect(self) -> None:
+        """Wait until all workers are connected"""
+
+        while len(self.connections) < self.processes:
+            connection = self.listener.accept()
+            connection.send(self.setup)
+            self.connections.append(connection)
+
+    def imap_unordered(self, func: Callable, iterable: Iterable) -> Iterator:
+        self.connect()
+        tasks = iter(iterable)
+        busy = []
+        done = object()
+
+        def submit(connection) -> None:
+            task = next(tasks, done)
+            if task is not done:
+                connection.send((func, task))
+                busy.append(connection)
+
+        for connection in self.connections:
+            submit(connection)
+
+        while busy:
+            for connection in wait(busy):
+                busy.remove(connection)
+                ok, result = connection.recv()
+                if not ok:
+                    raise RuntimeError(f"Task failed on a socket worker:\n{result}")
+                submit(connection)
+                yield result
+
+    def close(self) -> None:
+        for connection in self.connections:
+            try:
+                connection.send(None)
+            except OSError:
+                pass
+            connection.close()
+        self.connections = []
+        self.listener.close()
+
+
+def serve(address: Tuple[str, int], authkey: bytes = None) -> None:
+    """Work for the socket executor listening on address until it closes"""
+
+    authkey = authkey if authkey is not None else get_authkey()
+    with Client(address, authkey=authkey) as connection:
+        initializer, initargs = connection.recv()
+        if initializer is not None:
+            initializer(*initargs)
+
+        while True:
+            try:
+                message = connection.recv()
+            except EOFError:
+                return
+            if message is None:
+                return
+
+            func, task = message
+            try:
+                connection.send((True, func(task)))
+            except Exception:
+                connection.send((False, traceback.format_exc()))
+
+
+class RayExecutor(Executor):
+    """Tasks on a Ray cluster, the local one if no address is given"""
+
+    def __init__(
+        self, initializer: Callable = None, initargs: tuple = (), address: str = None
+    ) -> None:
+        import ray
+
+        self.ray = ray
+        ray.init(address=address, ignore_reinit_error=True)
+        self.call = ray.remote(initialized_call)
+        self.setup = (uuid.uuid4().hex, initializer, initargs)
+
+    def imap_unordered(self, func: Callable, iterable: Iterable) -> Iterator:
+        pending = [self.call.remote(self.setup, func, task) for task in iterable]
+        while pending:
+            done, pending = self.ray.wait(pending, num_returns=1)
+            yield self.ray.get(done[0])
+
+    def close(self) -> None:
+        self.ray.shutdown()
+
+
+class DaskExecutor(Executor):
+    """Tasks on a Dask cluster, a local one if no address is given"""
+
+    def __init__(
+        self, initializer: Callable = None, initargs: tuple = (), address: str = None
+    ) -> None:
+        from dask.distributed import Client as DaskClient, as_completed
+
+        self.as_completed = as_completed
+        self.client = DaskClient(address)
+        self.setup = (uuid.uuid4().hex, initializer, initargs)
+
+    def imap_unordered(self, func: Callable, iterable: Iterable) -> Iterator:
+        futures = [
+            self.client.submit(initialized_call, self.setup, func, task, pure=False)
+            for task in iterable
+        ]
+        for future in self.as_completed(futures):
+            yield future.result()
+
+    def close(self) -> None:
+        self.client.close()
+
+
+EXECUTORS = ["serial", "local", "socket", "ray", "dask"]
+
+
+def make_executor(
+    name: str,
+    initializer: Callable = None,
+    initargs: tuple = (),
+    address: str = None,
+    processes: Optional[int] = None,
+) -> Executor:
+    """
+    Executor by name. address is the HOST:PORT the socket executor listens
+    on, or the address of a Ray or Dask cluster. processes is the number of
+    pool processes or of socket workers to wait for.
+    """
+
+    if name == "serial":
+        return SerialExecutor(initializer, initargs)
+    if name == "local":
+        return LocalExecutor(initializer, initargs, processes)
+    if name == "socket":
+        return SocketExecutor(
+            initializer,
+            initargs,
+            parse_address(address or "localhost:0"),
+            processes or 1,
+        )
+    if name == "ray":
+        return RayExecutor(initializer, initargs, address)
+    if name == "dask":
+        return DaskExecutor(initializer, initargs, address)
+    raise ValueError(f"Unknown executor {name!r}, expected one of {EXECUTORS}")
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="Start socket executor workers")
+    parser.add_argument("address", help="HOST:PORT of the driver")
+    parser.add_argument(
+        "--processes",
+        type=int,
+        default=os.cpu_count(),
+        help="worker processes to start on this machine",
+    )
+    args = parser.parse_args()
+
+    address = parse_address(args.address)
+    workers = [
+        multiprocessing.Process(target=serve, args=(address,))
+        for _ in range(args.processes)
+    ]
+    for worker in workers:
+        worker.start()
+    for worker in workers:
+        worker.join()
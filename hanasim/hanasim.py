@@ -4,11 +4,12 @@ that implement hanabi strategies.
 """
 
 
-import json
 import random
 from abc import ABC, abstractmethod
 from collections import namedtuple
-from typing import List, Tuple, Set
+from collections.abc import Sequence
+from array import array
+from typing import List, Tuple
 
 # Define player action types
 ActionType = int
@@ -29,20 +30,201 @@ CARDCOUNTS = {
     Card(colour, rank): RANKCOUNTS[rank] for colour in COLOURS for rank in RANKS
 }
 
+# Cards are encoded as small integers colour * 5 + rank - 1 in compact state
+NUM_CARD_TYPES = len(COLOURS) * len(RANKS)
+CARDS = [Card(colour, rank) for colour in COLOURS for rank in RANKS]
+
+# Playable and critical cards at game start
+ONES = [Card(colour, ONE) for colour in COLOURS]
+FIVES = [Card(colour, FIVE) for colour in COLOURS]
+
+# Cleared state copied into the containers of a reset board
+EMPTY_FIREWORKS = [0] * len(COLOURS)
+EMPTY_COUNTS = [0] * NUM_CARD_TYPES
+
+
+# Unshuffled deck, ordered by colour and rank
+DECK = [
+    Card(colour, rank)
+    for colour in COLOURS
+    for rank in RANKS
+    for _ in range(RANKCOUNTS[rank])
+]
+
+
+def card_code(card: Card) -> int:
+    """Encode a card as an integer in range(NUM_CARD_TYPES)"""
+    colour, rank = card
+    return colour * len(RANKS) + rank - 1
+
+
+# Masks of the card codes of each colour and rank, and of all cards. A hand
+# slot's possibility mask has the bits of the cards it can still hold.
+COLOUR_MASKS = [sum(1 << card_code(Card(c, r)) for r in RANKS) for c in COLOURS]
+RANK_MASKS = {r: sum(1 << card_code(Card(c, r)) for c in COLOURS) for r in RANKS}
+ALL_CARDS_MASK = (1 << NUM_CARD_TYPES) - 1
+
+# Hint bits of a hand slot: the colours and ranks it was hinted positively,
+# from bit 0 and 5, and negatively, from bit 10 and 15
+POSITIVE_COLOUR, POSITIVE_RANK, NEGATIVE_COLOUR, NEGATIVE_RANK = 0, 5, 10, 15
+
+
+def shuffled_deck(rng=None) -> List[Card]:
+    """Shuffle a deck of Hanabi cards
+
+    :param rng: numpy Generator drawing the permutation of DECK. The global
+        random module shuffles the deck when rng is None.
+    """
+
+    if rng is None:
+        deck = list(DECK)
+        random.shuffle(deck)
+        return deck
+
+    return [DECK[i] for i in rng.permutation(len(DECK))]
+
+
+# Actions are logged as fixed-width records packing, from the lowest bit up,
+# action type (3 bits), player (3), target (6), value (3) and hand slot (3).
+# The target of a play or discard is the deck index of the card, the target
+# of a hint is the hinted player. A game over record holds the end condition.
+RECORD_TYPECODE = "I"
+MAXRECORDS = 128
+END_NORMAL, END_STRIKEOUT = 1, 2
+
+
+def encode_action(action_type, player, target, value=0, slot=0):
+    """Pack an action into a log record, works on ints and integer arrays"""
+    return action_type | player << 3 | target << 6 | value << 12 | slot << 15
+
+
+def decode_action(record: int) -> Tuple[int, int, int, int, int]:
+    """Unpack a log record into action type, player, target, value and slot"""
+    return (
+        record & 7,
+        record >> 3 & 7,
+        record >> 6 & 63,
+        record >> 12 & 7,
+        record >> 15 & 7,
+    )
+
+
+class ActionLog:
+    """The action records of one game, kept in a preallocated buffer"""
+
+    __slots__ = ("records", "length")
+
+    def __init__(self) -> None:
+        self.records = array(RECORD_TYPECODE, [0]) * MAXRECORDS
+        self.length = 0
+
+    def append(self, record: int) -> None:
+        if self.length == len(self.records):
+            self.records.extend(array(RECORD_TYPECODE, [0]) * MAXRECORDS)
+        self.records[self.length] = record
+        self.length += 1
+
+    def clear(self) -> None:
+        self.length = 0
+
+    def truncate(self, length: int) -> None:
+        """Drop the records after the first length, e.g. to undo moves"""
+        self.length = length
+
+    def view(self) -> memoryview:
+        """Records of the game so far, without copying"""
+        return memoryview(self.records)[: self.length]
+
+    def decode(self) -> List[Tuple[int, int, int, int, int]]:
+        """Unpack all records, see decode_action"""
+        return [decode_action(record) for record in self.view()]
+
+    def __len__(self) -> int:
+        return self.length
+
+    def __iter__(self):
+        return iter(self.view())
+
+
+# The action space of a game is fixed by its player count. Actions are
+# numbered plays per hand slot, then discards per hand slot, then colour and
+# rank hints per target, with targets counted clockwise from the acting player
+# (offset 1 is the next player). ACTION_MOVES[num_players][i] holds the action
+# type, slot or target offset and value of action i.
+def action_moves(num_players: int) -> List[Tuple[ActionType, int, int]]:
+    """Moves of the fixed action space of a player count"""
+
+    handsize = HANDSIZE[num_players]
+    offsets = range(1, num_players)
+    return (
+        [(PLAY, slot, 0) for slot in range(handsize)]
+        + [(DISCARD, slot, 0) for slot in range(handsize)]
+        + [(HINTCOLOUR, offset, colour) for offset in offsets for colour in COLOURS]
+        + [(HINTRANK, offset, rank) for offset in offsets for rank in RANKS]
+    )
+
+
+def legal_masks(num_players: int) -> List[List[int]]:
+    """
+    Masks of the legal actions indexed by hand length and whether a hint
+    token is left. Legality only depends on these two, so a board looks its
+    mask up instead of building it.
+    """
+
+    moves = action_moves(num_players)
+    masks = []
+    for hand_length in range(HANDSIZE[num_players] + 1):
+        no_hints = sum(
+            1 << i
+            for i, (action_type, slot, _) in enumerate(moves)
+            if action_type in (PLAY, DISCARD) and slot < hand_length
+        )
+        hints = sum(
+            1 << i
+            for i, (action_type, _, _) in enumerate(moves)
+            if action_type in (HINTCOLOUR, HINTRANK)
+        )
+        masks.append([no_hints, no_hints | hints])
+    return masks
+
+
+ACTION_MOVES = {num_players: action_moves(num_players) for num_players in HANDSIZE}
+ACTION_INDEX = {
+    num_players: {move: i for i, move in enumerate(moves)}
+    for num_players, moves in ACTION_MOVES.items()
+}
+LEGAL_MASKS = {num_players: legal_masks(num_players) for num_players in HANDSIZE}
+
+
+# Events a board dispatches to the players, named by their callback. A player
+# class subscribes to a subset with an EVENTS attribute, players without one
+# receive all events. Events are also in the action log, see Board.events_since.
+EVENTS = [DRAW, REMOVE, COLOUR_HINT, RANK_HINT] = [
+    "draw",
+    "remove",
+    "receive_colour_hint",
+    "receive_rank_hint",
+]
+ALL_EVENTS = frozenset(EVENTS)
+
 
 class AbstractAgent(ABC):
     """
     AbstractAgent is an abstract class defining the interface a player agent
-    for the hanasim class must implement.
+    for the hanasim class must implement. The board owns the hands, the draw
+    and remove callbacks only notify the agent of changes to its own hand.
+    Subclasses can narrow EVENTS to the callbacks they need.
     """
 
+    EVENTS = ALL_EVENTS
+
     @abstractmethod
     def draw(self, card: Card):
-        """draw a card from the deck and add it to the end of the hand"""
+        """a card was drawn from the deck and added to the end of the hand"""
 
     @abstractmethod
-    def remove(self, index: int) -> Card:
-        """remove a card from the hand. The card may be discarded or played"""
+    def remove(self, index: int):
+        """a card was removed from the hand. The card may be discarded or played"""
 
     @abstractmethod
     def receive_colour_hint(self, colour: int):
@@ -52,6 +234,25 @@ class AbstractAgent(ABC):
     def receive_rank_hint(self, rank: int):
         """receive a rank hint"""
 
+    def reset(self, game: "Board"):
+        """a new game starts on a reused board, clear all per-game state"""
+
+
+class HandView(Sequence):
+    """Read-only view of the cards in a hand, without copying the hand"""
+
+    __slots__ = ("deck", "indices")
+
+    def __init__(self, deck: List[Card], indices: List[int]) -> None:
+        self.deck = deck
+        self.indices = indices
+
+    def __getitem__(self, slot: int) -> Card:
+        return self.deck[self.indices[slot]]
+
+    def __len__(self) -> int:
+        return len(self.indices)
+
 
 class Board:
     """
@@ -69,8 +270,16 @@ class Board:
         self.game_over = False
 
         # global game state
-        self.players = [0] * num_players
+        self.players = [None] * num_players
         self.num_players = num_players
+
+        # callbacks of the subscribed players per event, None if unsubscribed
+        self.listeners = {event: [None] * num_players for event in EVENTS}
+        self._on_draw = self.listeners[DRAW]
+        self._on_remove = self.listeners[REMOVE]
+        self._on_colour_hint = self.listeners[COLOUR_HINT]
+        self._on_rank_hint = self.listeners[RANK_HINT]
+
         self.handsize = HANDSIZE[self.num_players]
         self.bonus_turns = num_players
 
@@ -82,20 +291,185 @@ class Board:
         self.index = 0
         self.deck = deck
         self.fireworks = [0] * len(COLOURS)
+
+        # hands of deck indices, each holding at most handsize cards
+        self.player_hands = [[] for _ in range(num_players)]
+
+        # possibility masks and hint bits per hand slot, see COLOUR_MASKS
+        self.slot_masks = [[] for _ in range(num_players)]
+        self.hint_bits = [[] for _ in range(num_players)]
+
+        # multiset of cards held in all hands and per player, by card code
+        self.hand_counts = [0] * NUM_CARD_TYPES
+        self.player_counts = [[0] * NUM_CARD_TYPES for _ in range(num_players)]
+
+        # fixed action space and its legal masks, see ACTION_MOVES
+        self.num_actions = len(ACTION_MOVES[num_players])
+        self._action_moves = ACTION_MOVES[num_players]
+        self._action_index = ACTION_INDEX[num_players]
+        self._legal_masks = LEGAL_MASKS[num_players]
+
+        # data for faster bookkeeping
+        self.action_log = ActionLog()
+        self.total_discarded = 0
+        self._init_card_state()
+
+    def _init_card_state(self) -> None:
+        """Initialize the discard pile and the derived card sets"""
+
         self.discard_pile = {
             Card(colour, rank): 0 for colour in COLOURS for rank in RANKS
         }
-
-        # data for faster bookkeeping
-        self.action_history = []
         self.played_cards = set()
         self.dead_cards = set()
-        self.critical_cards = set()
+        self.useless_cards = set()
+        self.critical_cards = set(FIVES)
+        self.playable_cards = set(ONES)
+
+    def reset(self, deck: List[Card] = None) -> None:
+        """
+        Clear the game state in place for a new game with deck, keeping the
+        players and all containers. Call setup to deal the new game.
+        """
+
+        self.game_over = False
+        self.bonus_turns = self.num_players
+        self.num_hints = self.MAXHINTS
+        self.num_strikes = 0
+        self.score = 0
+        self.turn = 0
+        self.index = 0
+        self.deck = deck
+        self.fireworks[:] = EMPTY_FIREWORKS
+
+        for hand in self.player_hands:
+            hand.clear()
+        for masks in self.slot_masks:
+            masks.clear()
+        for bits in self.hint_bits:
+            bits.clear()
+        self.hand_counts[:] = EMPTY_COUNTS
+        for counts in self.player_counts:
+            counts[:] = EMPTY_COUNTS
+
+        self.action_log.clear()
         self.total_discarded = 0
+        self._reset_card_state()
+
+    def _reset_card_state(self) -> None:
+        """Clear the discard pile and the derived card sets in place"""
+
+        discard_pile = self.discard_pile
+        for card in CARDS:
+            discard_pile[card] = 0
+        self.played_cards.clear()
+        self.dead_cards.clear()
+        self.useless_cards.clear()
+        self.critical_cards.clear()
+        self.critical_cards.update(FIVES)
+        self.playable_cards.clear()
+        self.playable_cards.update(ONES)
+
+    def snapshot(self) -> tuple:
+        """
+        Copy of the game state, to return to with restore after searching
+        ahead. The deck and the players are referenced, not copied.
+        """
+
+        return (
+            self.game_over,
+            self.bonus_turns,
+            self.num_hints,
+            self.num_strikes,
+            self.score,
+            self.turn,
+            self.index,
+            self.total_discarded,
+            self.deck,
+            self.fireworks[:],
+            [hand[:] for hand in self.player_hands],
+            [masks[:] for masks in self.slot_masks],
+            [bits[:] for bits in self.hint_bits],
+            self.hand_counts[:],
+            [counts[:] for counts in self.player_counts],
+            len(self.action_log),
+            self._snapshot_card_state(),
+        )
+
+    def restore(self, state: tuple) -> None:
+        """
+        Return to a snapshot of this board, in place so that hand views stay
+        valid. Players are not notified of the change.
+        """
+
+        (
+            self.game_over,
+            self.bonus_turns,
+            self.num_hints,
+            self.num_strikes,
+            self.score,
+            self.turn,
+            self.index,
+            self.total_discarded,
+            self.deck,
+            fireworks,
+            player_hands,
+            slot_masks,
+            hint_bits,
+            hand_counts,
+            player_counts,
+            log_length,
+            card_state,
+        ) = state
+
+        self.fireworks[:] = fireworks
+        for hand, saved in zip(self.player_hands, player_hands):
+            hand[:] = saved
+        for masks, saved in zip(self.slot_masks, slot_masks):
+            masks[:] = saved
+        for bits, saved in zip(self.hint_bits, hint_bits):
+            bits[:] = saved
+        self.hand_counts[:] = hand_counts
+        for counts, saved in zip(self.player_counts, player_counts):
+            counts[:] = saved
+        self.action_log.truncate(log_length)
+        self._restore_card_state(card_state)
+
+    def _snapshot_card_state(self) -> tuple:
+        """Copy of the discard pile and the derived card sets"""
+
+        return (
+            dict(self.discard_pile),
+            set(self.played_cards),
+            set(self.dead_cards),
+            set(self.useless_cards),
+            set(self.critical_cards),
+            set(self.playable_cards),
+        )
+
+    def _restore_card_state(self, card_state: tuple) -> None:
+        """Return the discard pile and card sets to a snapshot, in place"""
+
+        discard_pile, *card_sets = card_state
+        self.discard_pile.update(discard_pile)
+        own_sets = (
+            self.played_cards,
+            self.dead_cards,
+            self.useless_cards,
+            self.critical_cards,
+            self.playable_cards,
+        )
+        for cards, saved in zip(own_sets, card_sets):
+            cards.clear()
+            cards.update(saved)
 
     def set_player(self, player: AbstractAgent, player_id: int) -> None:
-        """Assign a player to the player list"""
+        """Assign a player to the player list and subscribe it to its events"""
+
         self.players[player_id] = player
+        events = () if player is None else getattr(type(player), "EVENTS", ALL_EVENTS)
+        for event, callbacks in self.listeners.items():
+            callbacks[player_id] = getattr(player, event) if event in events else None
 
     def setup(self) -> None:
         """Generate deck and deal cards"""
@@ -103,23 +477,32 @@ class Board:
         if not self.deck:
             self.generate_deck()
 
-        # Find all critical cards
-        self.critical_cards = {card for card in self.deck if CARDCOUNTS[card] == 1}
-
         # Deal cards to players
         self.deal()
 
-    def generate_deck(self) -> None:
-        """Generate a shuffled deck of Hanabi cards"""
+    def generate_deck(self, rng=None) -> None:
+        """Generate a shuffled deck of Hanabi cards
+
+        :param rng: numpy Generator to shuffle with, see shuffled_deck
+        """
+
+        self.deck = shuffled_deck(rng)
+
+    def replace_deck(self, deck: List[Card]) -> None:
+        """
+        Swap in a deck with other cards in the hands or the undrawn positions,
+        e.g. a determinized sample, recounting the cards held in the hands
+        """
 
-        deck = [
-            Card(colour, rank)
-            for colour in COLOURS
-            for rank in RANKS
-            for _ in range(RANKCOUNTS[rank])
-        ]
-        random.shuffle(deck)
         self.deck = deck
+        hand_counts = self.hand_counts
+        hand_counts[:] = EMPTY_COUNTS
+        for hand, counts in zip(self.player_hands, self.player_counts):
+            counts[:] = EMPTY_COUNTS
+            for position in hand:
+                code = card_code(deck[position])
+                hand_counts[code] += 1
+                counts[code] += 1
 
     def deal(self) -> None:
         """Deal cards from deck into player hands at start of game"""
@@ -135,73 +518,172 @@ class Board:
             self.bonus_turns -= 1
             if self.bonus_turns == 0:
                 self.game_over = True
-                self.action_history.append((ENDGAME, player_id, 1))
             return
 
         card = self.deck[self.index]
-        self.players[player_id].draw(card)
+        self.player_hands[player_id].append(self.index)
+        self.slot_masks[player_id].append(ALL_CARDS_MASK)
+        self.hint_bits[player_id].append(0)
+        code = card_code(card)
+        self.hand_counts[code] += 1
+        self.player_counts[player_id][code] += 1
         self.index += 1
 
+        callback = self._on_draw[player_id]
+        if callback is not None:
+            callback(card)
+
+    def remove(self, player_id: int, target: int) -> Card:
+        """Remove the card in a hand slot from a player's hand"""
+
+        card = self.deck[self.player_hands[player_id].pop(target)]
+        del self.slot_masks[player_id][target]
+        del self.hint_bits[player_id][target]
+        code = card_code(card)
+        self.hand_counts[code] -= 1
+        self.player_counts[player_id][code] -= 1
+
+        callback = self._on_remove[player_id]
+        if callback is not None:
+            callback(target)
+
+        return card
+
+    def get_hand(self, player_id: int, observer: int) -> HandView:
+        """Cards in the hand of player_id as seen by the observing player"""
+
+        if player_id == observer:
+            raise ValueError("A player cannot look at their own hand")
+        return HandView(self.deck, self.player_hands[player_id])
+
+    def visible_count(self, observer: int, card: Card) -> int:
+        """Number of copies of a card the observer sees in other hands"""
+
+        code = card_code(card)
+        return self.hand_counts[code] - self.player_counts[observer][code]
+
     def resolve_move(self, player: int, action_attempt: Action) -> Action:
         """Play out one move by a given player"""
 
         action_type, target, value = action_attempt
 
         if action_type == PLAY:
-            action = self.play(player, target, value)
+            position = self.hand_position(player, target)
+            if value not in COLOURS:
+                raise ValueError(f"No firework of colour {value}")
+            self.play(player, target, value)
+            record = encode_action(PLAY, player, position, value, target)
 
         elif action_type == DISCARD:
-            if self.num_hints < 8:
+            position = self.hand_position(player, target)
+            if self.num_hints < self.MAXHINTS:
                 self.num_hints += 1
-            action = self.discard(player, target)
+            self.discard(player, target)
+            record = encode_action(DISCARD, player, position, 0, target)
 
         elif action_type == HINTCOLOUR:
-            assert player != target
-            assert self.num_hints > 0
+            self.check_hint(player, target, value in COLOURS)
             self.hint_colour(target, value)
-            action = (HINTCOLOUR, target, value)
+            record = encode_action(HINTCOLOUR, player, target, value)
 
         elif action_type == HINTRANK:
-            assert player != target
-            assert self.num_hints > 0
+            self.check_hint(player, target, value in RANKS)
             self.hint_rank(target, value)
-            action = (HINTRANK, value)
+            record = encode_action(HINTRANK, player, target, value)
 
         else:
             raise ValueError("Invalid action type")
 
-        self.action_history.append(action)
+        self.action_log.append(record)
         if self.num_strikes == self.MAXSTRIKES:
-            self.action_history.append((ENDGAME, player, 2))
             self.game_over = True
 
+        if self.game_over:
+            strikeout = self.num_strikes == self.MAXSTRIKES
+            reason = END_STRIKEOUT if strikeout else END_NORMAL
+            self.action_log.append(encode_action(ENDGAME, player, player, reason))
+
         self.turn += 1
 
+    def hand_position(self, player_id: int, slot: int) -> int:
+        """Deck index of the card in a hand slot, for a play or discard"""
+
+        hand = self.player_hands[player_id]
+        if not 0 <= slot < len(hand):
+            raise ValueError(f"Player {player_id} has no card in slot {slot}")
+        return hand[slot]
+
+    def check_hint(self, player_id: int, target: int, valid_value: bool) -> None:
+        """Raise ValueError unless player_id can give the hint"""
+
+        if self.num_hints == 0:
+            raise ValueError("No hint tokens left")
+        if target == player_id or not 0 <= target < self.num_players:
+            raise ValueError(f"Player {player_id} cannot hint player {target}")
+        if not valid_value:
+            raise ValueError("Invalid hint value")
+
+    def legal_actions(self, player_id: int) -> int:
+        """Bitmask of the legal actions of player_id, see ACTION_MOVES"""
+
+        has_hints = self.num_hints > 0
+        return self._legal_masks[len(self.player_hands[player_id])][has_hints]
+
+    def is_legal(self, player_id: int, index: int) -> bool:
+        """Whether action index of the action space is legal for player_id"""
+        return self.legal_actions(player_id) >> index & 1 == 1
+
+    def action_to_move(self, player_id: int, index: int) -> Action:
+        """
+        Move of player_id for an action of the action space. A card is played
+        onto the firework of its own colour.
+        """
+
+        action_type, target, value = self._action_moves[index]
+        if action_type == PLAY:
+            value = self.deck[self.hand_position(player_id, target)].colour
+        elif action_type in (HINTCOLOUR, HINTRANK):
+            target = (player_id + target) % self.num_players
+        return (action_type, target, value)
+
+    def move_to_action(self, player_id: int, move: Action) -> int:
+        """Index in the action space of a move of player_id"""
+
+        action_type, target, value = move
+        if action_type in (HINTCOLOUR, HINTRANK):
+            target = (target - player_id) % self.num_players
+        else:
+            value = 0
+        return self._action_index[action_type, target, value]
+
     def play(self, player_id: int, target: int, colour: int) -> Action:
         """Resolve a move where player_id plays a card from its hand."""
 
         # Remove card from player's hand
-        card = self.players[player_id].remove(target)
+        card = self.remove(player_id, target)
         self.draw(player_id)
         action = (PLAY, card, colour)
 
         # If card is illegal, discard with strike
         if card.colour != colour or card.rank != self.fireworks[colour] + 1:
             self.num_strikes += 1
-            self.discard_pile[card] += 1
+            self.add_to_discard_pile(card)
             return action
 
-        # Play the card
+        # Play the card and make the next card of the firework playable
         self.fireworks[colour] += 1
         self.played_cards.add(card)
+        self.useless_cards.add(card)
+        self.playable_cards.remove(card)
+        if card.rank < FIVE:
+            self.playable_cards.add(Card(colour, card.rank + 1))
         self.score += 1
 
         if self.score == 25:
             self.game_over = True
 
         # If the played card was critical, remove it from the critical card stack
-        if card in self.critical_cards:
-            self.critical_cards.remove(card)
+        self.critical_cards.discard(card)
 
         # A hint is obtained if the firework is completed
         if self.fireworks[colour] == FIVE and self.num_hints < self.MAXHINTS:
@@ -213,32 +695,55 @@ class Board:
         """Discard a card"""
 
         # remove card from player hand and draw new card
-        card = self.players[player_id].remove(target)
+        card = self.remove(player_id, target)
         self.draw(player_id)
 
         # move card onto discard pile
-        self.discard_pile[card] += 1
+        self.add_to_discard_pile(card)
         self.total_discarded += 1
 
-        # account for critical and dead cards after discount
-        num_discarded = self.discard_pile[card]
-        num_left = CARDCOUNTS[card] - num_discarded
+        return (DISCARD, card, 0)
+
+    def add_to_discard_pile(self, card: Card) -> None:
+        """Move a discarded or misplayed card onto the discard pile"""
+
+        self.discard_pile[card] += 1
+
+        # copies of played or dead cards do not change critical and dead cards
+        if card in self.useless_cards:
+            return
+
+        # account for critical and dead cards after discard
+        num_left = CARDCOUNTS[card] - self.discard_pile[card]
         if num_left == 1:
             self.critical_cards.add(card)
 
-        if num_left == 0:
+        elif num_left == 0:
             colour, rank = card
-            for r in range(rank, RANKS[-1] + 1):
-                self.critical_cards.discard(Card(colour, r))
-                self.dead_cards.add(Card(colour, r))
-
-        return (DISCARD, card, 0)
+            for r in range(rank, FIVE + 1):
+                dead = Card(colour, r)
+                self.critical_cards.discard(dead)
+                self.dead_cards.add(dead)
+                self.useless_cards.add(dead)
 
     def hint_colour(self, player_id: int, value: int) -> None:
         """Provide a colour hint to a player"""
 
         self.num_hints -= 1
-        self.players[player_id].receive_colour_hint(value)
+        deck = self.deck
+        masks, bits = self.slot_masks[player_id], self.hint_bits[player_id]
+        colour_mask = COLOUR_MASKS[value]
+        for slot, position in enumerate(self.player_hands[player_id]):
+            if deck[position].colour == value:
+                masks[slot] &= colour_mask
+                bits[slot] |= 1 << POSITIVE_COLOUR + value
+            else:
+                masks[slot] &= ~colour_mask
+                bits[slot] |= 1 << NEGATIVE_COLOUR + value
+
+        callback = self._on_colour_hint[player_id]
+        if callback is not None:
+            callback(value)
 
     def hint_rank(self, player_id: int, value: int) -> None:
         """Provide a rank hint to a player
@@ -248,15 +753,78 @@ class Board:
         """
 
         self.num_hints -= 1
-        self.players[player_id].receive_rank_hint(value)
+        deck = self.deck
+        masks, bits = self.slot_masks[player_id], self.hint_bits[player_id]
+        rank_mask = RANK_MASKS[value]
+        for slot, position in enumerate(self.player_hands[player_id]):
+            if deck[position].rank == value:
+                masks[slot] &= rank_mask
+                bits[slot] |= 1 << POSITIVE_RANK + value - 1
+            else:
+                masks[slot] &= ~rank_mask
+                bits[slot] |= 1 << NEGATIVE_RANK + value - 1
+
+        callback = self._on_rank_hint[player_id]
+        if callback is not None:
+            callback(value)
+
+    def events_since(self, position: int) -> memoryview:
+        """
+        Action records logged since the log held position records, e.g. all
+        moves since a player's last turn. A play or discard implies a draw,
+        and the hinted slots are in slot_masks.
+        """
+        return self.action_log.view()[position:]
+
+    def possible_cards(self, player_id: int, slot: int) -> List[Card]:
+        """Cards the hints given so far allow in a hand slot"""
+
+        mask = self.slot_masks[player_id][slot]
+        return [card for code, card in enumerate(CARDS) if mask >> code & 1]
+
+    @property
+    def action_history(self) -> List[Tuple[int, int, int, int, int]]:
+        """Decoded action log of the game"""
+        return self.action_log.decode()
+
+    def is_playable(self, card: Card) -> bool:
+        """Whether a card can be played on the fireworks right now"""
+        return card in self.playable_cards
+
+    def is_useless(self, card: Card) -> bool:
+        """Whether a card has been played or can no longer be played"""
+        return card in self.useless_cards
+
+    def is_critical(self, card: Card) -> bool:
+        """Whether a card is the last copy still needed"""
+        return card in self.critical_cards
+
+    def is_dead(self, card: Card) -> bool:
+        """Whether a card can no longer be played"""
+        return card in self.dead_cards
+
+    @property
+    def discard_counts(self) -> List[int]:
+        """Number of discarded copies per card code"""
+        return [self.discard_pile[card] for card in CARDS]
 
     @property
-    def playable_cards(self) -> Set[namedtuple]:
-        """Returns a set of all playable cards"""
+    def max_score(self) -> int:
+        """Highest score still reachable given the dead cards"""
+        return len(COLOURS) * len(RANKS) - len(self.dead_cards)
+
+    @property
+    def pace(self) -> int:
+        """Number of discards left before the maximum score is out of reach"""
+        cards_left = len(self.deck) - self.index
+        return self.score + cards_left + self.num_players - self.max_score
+
+
+def play_game(game: Board, agents: list) -> Board:
+    """Play a set up game to the end, agents pick moves with find_move"""
 
-        playable_cards = set()
-        for colour, rank in enumerate(self.fireworks):
-            if rank + 1 <= FIVE:
-                playable_cards.add((colour, rank + 1))
+    while not game.game_over:
+        player_id = game.turn % game.num_players
+        game.resolve_move(player_id, agents[player_id].find_move(game))
 
-        return playable_cards
+    return game
@@ -0,0 +1,94 @@
+"""
+Opt-in instrumentation of the simulation hot path.
+
+instrument() derives a Board subclass that times resolve_move per action type,
+draw and generate_deck, and TimedAgent times an agent's find_move. Phases nest:
+the time of a play or discard includes its draw. Uninstrumented runs use the
+plain classes and pay nothing.
+"""
+
+import time
+from typing import Dict
+
+from hanasim.hanasim import Board, DISCARD, HINTCOLOUR, HINTRANK, PLAY
+
+ACTION_PHASES = {
+    PLAY: "resolve_move:PLAY",
+    DISCARD: "resolve_move:DISCARD",
+    HINTCOLOUR: "resolve_move:HINTCOLOUR",
+    HINTRANK: "resolve_move:HINTRANK",
+}
+
+
+class Counters:
+    """Call counts and cumulative time in seconds per phase"""
+
+    def __init__(self) -> None:
+        self.calls: Dict[str, int] = {}
+        self.seconds: Dict[str, float] = {}
+
+    def add(self, phase: str, seconds: float, calls: int = 1) -> None:
+        self.calls[phase] = self.calls.get(phase, 0) + calls
+        self.seconds[phase] = self.seconds.get(phase, 0.0) + seconds
+
+    def clear(self) -> None:
+        self.calls.clear()
+        self.seconds.clear()
+
+    def merge(self, other: "Counters") -> "Counters":
+        """Add the counts of another set of counters, e.g. of another worker"""
+
+        for phase, calls in other.calls.items():
+            self.add(phase, other.seconds[phase], calls)
+        return self
+
+    def summary(self) -> str:
+        """Table of calls, total time and mean time per call of each phase"""
+
+        lines = [f"{'phase':<24}{'calls':>12}{'total s':>12}{'us/call':>10}"]
+        for phase in sorted(self.calls):
+            calls, seconds = self.calls[phase], self.seconds[phase]
+            lines.append(
+                f"{phase:<24}{calls:>12}{seconds:>12.3f}{1e6 * seconds / calls:>10.2f}"
+            )
+        return "\n".join(lines)
+
+
+def instrument(board_class: type, counters: Counters) -> type:
+    """Subclass of a board class that records its phases in counters"""
+
+    class InstrumentedBoard(board_class):
+        def resolve_move(self, player, action_attempt):
+            tic = time.perf_counter()
+            super().resolve_move(player, action_attempt)
+            counters.add(ACTION_PHASES[action_attempt[0]], time.perf_counter() - tic)
+
+        def draw(self, player_id):
+            tic = time.perf_counter()
+            super().draw(player_id)
+            counters.add("draw", time.perf_counter() - tic)
+
+        def generate_deck(self, rng=None):
+            tic = time.perf_counter()
+            super().generate_deck(rng)
+            counters.add("generate_deck", time.perf_counter() - tic)
+
+    InstrumentedBoard.__name__ = f"Instrumented{board_class.__name__}"
+    return InstrumentedBoard
+
+
+class TimedAgent:
+    """Wrapper recording the time an agent spends in find_move"""
+
+    def __init__(self, agent, counters: Counters) -> None:
+        self.agent = agent
+        self.counters = counters
+
+    def reset(self, game: Board) -> None:
+        self.agent.reset(game)
+
+    def find_move(self, game: Board):
+        tic = time.perf_counter()
+        action = self.agent.find_move(game)
+        self.counters.add("find_move", time.perf_counter() - tic)
+        return action
@@ -0,0 +1,194 @@
+"""
+Opt-in memory profiling of the simulation hot path.
+
+Every sampled game is played with tracemalloc tracing, which is too slow to
+leave on for a whole sweep. track() derives a Board subclass and
+TrackedAgent wraps an agent, both recording per call the bytes allocated
+above the traced memory at the start of the call, its peak, and the bytes
+still held when it returns. A game that keeps the second number at zero
+does not grow, and a hot loop that keeps both near zero does not allocate.
+Calls do not nest: a search agent's own resolve_move calls reset the peak
+of its find_move.
+
+After every sample MemoryCounters also records the resident set size of the
+worker, so growth over the untraced games in between shows up too.
+"""
+
+import os
+import tracemalloc
+from typing import Dict, List, Tuple
+
+from hanasim.hanasim import Board
+
+PAGESIZE = os.sysconf("SC_PAGE_SIZE") if hasattr(os, "sysconf") else 4096
+
+
+def rss_bytes() -> int:
+    """Resident set size of this process, its peak where /proc is missing"""
+
+    try:
+        with open("/proc/self/statm") as f:
+            return int(f.read().split()[1]) * PAGESIZE
+    except OSError:
+        import resource
+
+        return resource.getrusage(resource.RUSAGE_SELF).ru_maxrss * 1024
+
+
+class MemoryCounters:
+    """
+    Allocated and retained bytes per phase over the sampled games, and the
+    resident set size of each worker by number of games played
+    """
+
+    def __init__(self) -> None:
+        self.calls: Dict[str, int] = {}
+        self.allocated: Dict[str, int] = {}
+        self.retained: Dict[str, int] = {}
+        self.games = 0
+        self.turns = 0
+        self.rss: Dict[int, List[Tuple[int, int]]] = {}
+
+    def add(self, phase: str, allocated: int, retained: int) -> None:
+        self.calls[phase] = self.calls.get(phase, 0) + 1
+        self.allocated[phase] = self.allocated.get(phase, 0) + allocated
+        self.retained[phase] = self.retained.get(phase, 0) + retained
+
+    def add_game(self, game: Board) -> None:
+        """Count a sampled game and its turns"""
+
+        self.games += 1
+        self.turns += game.turn
+
+    def sample_rss(self, games_played: int) -> None:
+        """Record the resident set size after a worker played games_played"""
+        self.rss.setdefault(os.getpid(), []).append((games_played, rss_bytes()))
+
+    def clear(self) -> None:
+        self.calls.clear()
+        self.allocated.clear()
+        self.retained.clear()
+        self.games = 0
+        self.turns = 0
+        self.rss.clear()
+
+    def merge(self, other: "MemoryCounters") -> "MemoryCounters":
+        """Add the counts of another set of counters, e.g. of another worker"""
+
+        for phase, calls in other.calls.items():
+            allocated, retained = other.allocated[phase], other.retained[phase]
+            self.calls[phase] = self.calls.get(phase, 0) + calls
+            self.allocated[phase] = self.allocated.get(phase, 0) + allocated
+            self.retained[phase] = self.retained.get(phase, 0) + retained
+        self.games += other.games
+        self.turns += other.turns
+        for pid, samples in other.rss.items():
+            self.rss.setdefault(pid, []).extend(samples)
+        return self
+
+    def per_game(self, phase: str) -> float:
+        """Bytes allocated per sampled game by a phase"""
+        return self.allocated.get(phase, 0) / max(self.games, 1)
+
+    def per_turn(self, phase: str) -> float:
+        """Bytes allocated per turn of the sampled games by a phase"""
+        return self.allocated.get(phase, 0) / max(self.turns, 1)
+
+    def over_budget(self, bytes_per_turn: float) -> List[str]:
+        """Phases allocating more than bytes_per_turn per sampled turn"""
+        return [
+            phase
+            for phase in sorted(self.calls)
+            if self.per_turn(phase) > bytes_per_turn
+        ]
+
+    def summary(self) -> str:
+        """Tables of the bytes per phase and of the RSS growth per worker"""
+
+        lines = [
+            f"{self.games} sampled games, {self.turns} turns",
+            f"{'phase':<32}{'calls':>10}{'B/call':>10}{'B/game':>10}"
+            f"{'B/turn':>10}{'kept B/game':>12}",
+        ]
+        for phase in sorted(self.calls):
+            calls = self.calls[phase]
+            retained = self.retained[phase] / max(self.games, 1)
+            lines.append(
+                f"{phase:<32}{calls:>10}{self.allocated[phase] / calls:>10.1f}"
+                f"{self.per_game(phase):>10.1f}{self.per_turn(phase):>10.1f}"
+                f"{retained:>12.1f}"
+            )
+
+        lines.append(
+            f"{'worker':<10}{'games':>10}{'first MB':>10}{'last MB':>10}"
+            f"{'KB/1000 games':>15}"
+        )
+        for pid, samples in sorted(self.rss.items()):
+            samples = sorted(samples)
+            first_games, first_rss = samples[0]
+            last_games, last_rss = samples[-1]
+            games = max(last_games - first_games, 1)
+            growth = (last_rss - first_rss) / 1024 * 1000 / games
+            lines.append(
+                f"{pid:<10}{last_games:>10}{first_rss / 2**20:>10.1f}"
+                f"{last_rss / 2**20:>10.1f}{growth:>15.1f}"
+            )
+        return "\n".join(lines)
+
+
+def measure(counters: MemoryCounters, phase: str, func, *args):
+    """Call func, recording its allocations in counters while tracing"""
+
+    if not tracemalloc.is_tracing():
+        return func(*args)
+    start, _ = tracemalloc.get_traced_memory()
+    tracemalloc.reset_peak()
+    result = func(*args)
+    current, peak = tracemalloc.get_traced_memory()
+    counters.add(phase, peak - start, current - start)
+    return result
+
+
+def track(board_class: type, counters: MemoryCounters) -> type:
+    """Subclass of a board class that records the allocations of its moves"""
+
+    class TrackedBoard(board_class):
+        def resolve_move(self, player, action_attempt):
+            parent = super().resolve_move
+            return measure(counters, "resolve_move", parent, player, action_attempt)
+
+        def reset(self, deck=None):
+            return measure(counters, "reset", super().reset, deck)
+
+        def setup(self):
+            return measure(counters, "setup", super().setup)
+
+    TrackedBoard.__name__ = f"Tracked{board_class.__name__}"
+    return TrackedBoard
+
+
+class TrackedAgent:
+    """Wrapper recording the allocations of an agent's find_move"""
+
+    def __init__(self, agent, counters: MemoryCounters, name: str) -> None:
+        self.agent = agent
+        self.counters = counters
+        self.phase = f"find_move:{name}"
+
+    def reset(self, game: Board) -> None:
+        self.agent.reset(game)
+
+    def find_move(self, game: Board):
+        return measure(self.counters, self.phase, self.agent.find_move, game)
+
+
+def traced(counters: MemoryCounters, play, *args) -> Board:
+    """Play a game with tracing on, count it and return the finished board"""
+
+    tracemalloc.start()
+    try:
+        game = play(*args)
+    finally:
+        tracemalloc.stop()
+    counters.add_game(game)
+    return game
@@ -0,0 +1,177 @@
+"""
+Compiled card-state transitions behind the Board interface.
+
+NativeBoard keeps the packed card state of PackedBoard in NumPy arrays and
+moves it with small kernels for plays and discards. The kernels are compiled
+with numba when it is installed and otherwise run as plain Python, so
+NativeBoard always behaves exactly like PackedBoard and Board, the reference
+implementation. NATIVE tells whether the kernels are compiled. Every move
+still dispatches to the kernels from Python and reads the masks back, so
+NativeBoard is opt-in and DEFAULT_BACKEND names PackedBoard.
+"""
+
+import numpy as np
+
+from hanasim.hanasim import Action, Board, DISCARD, FIVE, PLAY, RANKS, card_code
+from hanasim.packed import CODECOUNTS, FIVES_MASK, ONES_MASK, RUN_MASKS, PackedBoard
+
+try:
+    from numba import njit
+
+    NATIVE = True
+except ImportError:
+    NATIVE = False
+
+    def njit(*args, **kwargs):
+        """Run the kernels uncompiled"""
+        if args and callable(args[0]):
+            return args[0]
+        return lambda function: function
+
+
+# Layout of the card mask array of a NativeBoard
+NUM_MASKS = 5
+PLAYED, DEAD, USELESS, CRITICAL, PLAYABLE = range(NUM_MASKS)
+INITIAL_MASKS = [0, 0, 0, FIVES_MASK, ONES_MASK]
+
+CODE_COUNTS = np.array(CODECOUNTS, dtype=np.int64)
+CODE_RUNS = np.array(RUN_MASKS, dtype=np.int64)
+NUM_RANKS = len(RANKS)
+
+
+@njit(cache=True)
+def discard_code(masks, discards, counts, runs, code):
+    """Move a card onto the discard pile, updating critical and dead cards"""
+
+    discards[code] += 1
+
+    # copies of played or dead cards do not change critical and dead cards
+    if masks[USELESS] >> code & 1:
+        return
+
+    num_left = counts[code] - discards[code]
+    if num_left == 1:
+        masks[CRITICAL] |= 1 << code
+
+    elif num_left == 0:
+        dead = runs[code]
+        masks[CRITICAL] &= ~dead
+        masks[DEAD] |= dead
+        masks[USELESS] |= dead
+
+
+@njit(cache=True)
+def play_code(masks, discards, counts, runs, code, colour):
+    """
+    Play a card onto a firework. Returns whether it was playable, a misplayed
+    card is discarded.
+    """
+
+    bit = 1 << code
+    if code // NUM_RANKS != colour or not masks[PLAYABLE] & bit:
+        discard_code(masks, discards, counts, runs, code)
+        return False
+
+    masks[PLAYED] |= bit
+    masks[USELESS] |= bit
+    masks[CRITICAL] &= ~bit
+    masks[PLAYABLE] &= ~bit
+    if code % NUM_RANKS != NUM_RANKS - 1:
+        masks[PLAYABLE] |= bit << 1
+    return True
+
+
+class NativeBoard(PackedBoard):
+    """
+    PackedBoard whose card masks and discard counts live in NumPy arrays
+    moved by the play and discard kernels. The masks are also readable as the
+    integer attributes of PackedBoard.
+    """
+
+    def _init_card_state(self) -> None:
+        """Allocate the card mask and discard count arrays"""
+
+        self._masks = np.zeros(NUM_MASKS, dtype=np.int64)
+        self._discards = np.zeros(len(CODECOUNTS), dtype=np.int64)
+        self._reset_card_state()
+
+    def _reset_card_state(self) -> None:
+        """Reset the card masks and clear the discard counts in place"""
+
+        self._masks[:] = INITIAL_MASKS
+        self._discards[:] = 0
+
+    def _snapshot_card_state(self) -> tuple:
+        """Copy of the card masks and discard counts"""
+        return (self._masks.tolist(), self._discards.tolist())
+
+    def _restore_card_state(self, card_state: tuple) -> None:
+        """Return the card masks and discard counts to a snapshot"""
+
+        masks, discards = card_state
+        self._masks[:] = masks
+        self._discards[:] = discards
+
+    def play(self, player_id: int, target: int, colour: int) -> Action:
+        """Resolve a move where player_id plays a card from its hand."""
+
+        card = self.remove(player_id, target)
+        self.draw(player_id)
+        action = (PLAY, card, colour)
+
+        code = card_code(card)
+        if not play_code(
+            self._masks, self._discards, CODE_COUNTS, CODE_RUNS, code, colour
+        ):
+            self.num_strikes += 1
+            return action
+
+        self.fireworks[colour] += 1
+        self.score += 1
+        if self.score == 25:
+            self.game_over = True
+
+        # A hint is obtained if the firework is completed
+        if card.rank == FIVE and self.num_hints < self.MAXHINTS:
+            self.num_hints += 1
+
+        return action
+
+    def discard(self, player_id: int, target: int) -> Action:
+        """Discard a card"""
+
+        card = self.remove(player_id, target)
+        self.draw(player_id)
+        self._add_code_to_discard_pile(card_code(card))
+        self.total_discarded += 1
+
+        return (DISCARD, card, 0)
+
+    def _add_code_to_discard_pile(self, code: int) -> None:
+        """Move a card, given by its code, onto the discard pile"""
+        discard_code(self._masks, self._discards, CODE_COUNTS, CODE_RUNS, code)
+
+    @property
+    def _played(self) -> int:
+        return int(self._masks[PLAYED])
+
+    @property
+    def _dead(self) -> int:
+        return int(self._masks[DEAD])
+
+    @property
+    def _useless(self) -> int:
+        return int(self._masks[USELESS])
+
+    @property
+    def _critical(self) -> int:
+        return int(self._masks[CRITICAL])
+
+    @property
+    def _playable(self) -> int:
+        return int(self._masks[PLAYABLE])
+
+
+# Board implementations by name, all interchangeable
+BACKENDS = {"python": Board, "packed": PackedBoard, "native": NativeBoard}
+DEFAULT_BACKEND = "packed"
@@ -0,0 +1,140 @@
+"""
+Fixed-layout observations for learning agents.
+
+ObservationEncoder writes what one player sees of a game as 0/1 features into
+a NumPy buffer given by the caller, e.g. a row of a preallocated uint8 or
+float32 training batch. The layout only depends on the player count. Hands
+are ordered by seat, starting after the observer for the visible hands and
+with the observer for the hint knowledge:
+
+    fireworks  25          played cards, by card code
+    hints      8           thermometer of the hint tokens
+    strikes    3           thermometer of the strikes
+    discards   50          thermometer of the discarded copies per card code
+    hands      (P-1)*H*25  one-hot card code per slot of the other hands
+    knowledge  P*H*25      slot masks, the cards each slot can still hold
+
+Empty slots are all zeros. encode reads any Board implementation,
+encode_batch all games of a BatchBoard at once.
+"""
+
+from typing import Dict
+
+import numpy as np
+
+from hanasim.hanasim import (
+    Board,
+    CARDS,
+    HANDSIZE,
+    NUM_CARD_TYPES,
+    card_code,
+)
+from hanasim.packed import CODECOUNTS
+
+CODE_SHIFTS = np.arange(NUM_CARD_TYPES, dtype=np.int64)
+CODE_COLOURS = np.array([card.colour for card in CARDS])
+CODE_RANKS = np.array([card.rank for card in CARDS])
+
+# Card code and copy number of every unit of the discard thermometer
+DISCARD_CODES = np.repeat(CODE_SHIFTS, CODECOUNTS)
+DISCARD_COPIES = np.concatenate([np.arange(count) for count in CODECOUNTS])
+
+HINT_UNITS = np.arange(Board.MAXHINTS)
+STRIKE_UNITS = np.arange(Board.MAXSTRIKES)
+
+
+class ObservationEncoder:
+    """Encoder of the observations of games with num_players players"""
+
+    def __init__(self, num_players: int) -> None:
+        self.num_players = num_players
+        self.handsize = HANDSIZE[num_players]
+
+        hand_features = self.handsize * NUM_CARD_TYPES
+        widths = [
+            ("fireworks", NUM_CARD_TYPES),
+            ("hints", len(HINT_UNITS)),
+            ("strikes", len(STRIKE_UNITS)),
+            ("discards", len(DISCARD_CODES)),
+            ("hands", (num_players - 1) * hand_features),
+            ("knowledge", num_players * hand_features),
+        ]
+        self.sections: Dict[str, slice] = {}
+        start = 0
+        for name, width in widths:
+            self.sections[name] = slice(start, start + width)
+            start += width
+        self.size = start
+
+        # Seats of the other hands and of all hands, relative to the observer
+        self.hand_offsets = np.arange(1, num_players)
+        self.knowledge_offsets = np.arange(num_players)
+
+    def encode(
+        self, game: Board, observer: int, out: np.ndarray = None
+    ) -> np.ndarray:
+        """Observation of the observer, written into out of shape (size,)"""
+
+        if out is None:
+            out = np.zeros(self.size, dtype=np.uint8)
+        sections = self.sections
+        num_players, handsize = self.num_players, self.handsize
+
+        fireworks = np.asarray(game.fireworks)
+        out[sections["fireworks"]] = fireworks[CODE_COLOURS] >= CODE_RANKS
+        out[sections["hints"]] = HINT_UNITS < game.num_hints
+        out[sections["strikes"]] = STRIKE_UNITS < game.num_strikes
+        discards = np.asarray(game.discard_counts)
+        out[sections["discards"]] = discards[DISCARD_CODES] > DISCARD_COPIES
+
+        deck = game.deck
+        codes = np.full((num_players - 1, handsize), -1)
+        for row, offset in enumerate(self.hand_offsets.tolist()):
+            hand = game.player_hands[(observer + offset) % num_players]
+            codes[row, : len(hand)] = [card_code(deck[i]) for i in hand]
+        out[sections["hands"]] = (codes[..., None] == CODE_SHIFTS).ravel()
+
+        masks = np.zeros((num_players, handsize), dtype=np.int64)
+        for row, offset in enumerate(self.knowledge_offsets.tolist()):
+            slot_masks = game.slot_masks[(observer + offset) % num_players]
+            masks[row, : len(slot_masks)] = slot_masks
+        out[sections["knowledge"]] = ((masks[..., None] >> CODE_SHIFTS) & 1).ravel()
+
+        return out
+
+    def encode_batch(
+        self, batch, observers: np.ndarray = None, out: np.ndarray = None
+    ) -> np.ndarray:
+        """
+        Observations of a hanasim.batch.BatchBoard, one row per game, by
+        default of the current players. Written into out of shape
+        (num_games, size).
+        """
+
+        num_games = batch.num_games
+        if observers is None:
+            observers = batch.current_player
+        if out is None:
+            out = np.zeros((num_games, self.size), dtype=np.uint8)
+        sections = self.sections
+        rows = np.arange(num_games)[:, None]
+
+        out[:, sections["fireworks"]] = batch.fireworks[:, CODE_COLOURS] >= CODE_RANKS
+        out[:, sections["hints"]] = HINT_UNITS < batch.num_hints[:, None]
+        out[:, sections["strikes"]] = STRIKE_UNITS < batch.num_strikes[:, None]
+        discards = batch.discard_pile[:, DISCARD_CODES]
+        out[:, sections["discards"]] = discards > DISCARD_COPIES
+
+        seats = (observers[:, None] + self.hand_offsets) % self.num_players
+        positions = batch.hands[rows, seats].astype(np.intp)
+        codes = batch.decks[rows[:, :, None], np.maximum(positions, 0)]
+        codes = np.where(positions >= 0, codes, -1)
+        hands = codes[..., None] == CODE_SHIFTS
+        out[:, sections["hands"]] = hands.reshape(num_games, -1)
+
+        seats = (observers[:, None] + self.knowledge_offsets) % self.num_players
+        masks = batch.slot_masks[rows, seats]
+        knowledge = (masks[..., None] >> CODE_SHIFTS) & 1
+        out[:, sections["knowledge"]] = knowledge.reshape(num_games, -1)
+
+        return out
@@ -0,0 +1,271 @@
+"""
+Compact game-state representation for the hanasim Board.
+
+PackedBoard keeps the same interface as hanasim.Board, but encodes cards as
+small integers (colour * 5 + rank - 1). The discard pile is a fixed 25-slot
+count array and the played, dead, useless, critical and playable cards are
+kept as 25-bit masks, so no tuples are hashed on the play and discard paths.
+"""
+
+from collections.abc import Mapping, Set
+from typing import Iterable, Iterator
+
+from hanasim.hanasim import (
+    Action,
+    Board,
+    CARDCOUNTS,
+    CARDS,
+    Card,
+    COLOURS,
+    DISCARD,
+    EMPTY_COUNTS,
+    FIVE,
+    NUM_CARD_TYPES,
+    ONE,
+    PLAY,
+    card_code,
+)
+
+# Number of copies in deck for each card code
+CODECOUNTS = [CARDCOUNTS[card] for card in CARDS]
+
+# Bit of each card in a card mask, keyed by card
+CARD_BITS = {card: 1 << card_code(card) for card in CARDS}
+
+# Masks of the playable and critical cards at game start
+ONES_MASK = sum(1 << card_code(Card(colour, ONE)) for colour in COLOURS)
+FIVES_MASK = sum(1 << card_code(Card(colour, FIVE)) for colour in COLOURS)
+
+# Mask of all cards of the same colour with rank equal or higher than a code
+RUN_MASKS = [
+    sum(1 << card_code(Card(colour, r)) for r in range(rank, FIVE + 1))
+    for colour, rank in CARDS
+]
+
+
+class CardSet(Set):
+    """Read-only set of cards backed by a 25-bit mask"""
+
+    __slots__ = ("mask",)
+
+    def __init__(self, mask: int = 0) -> None:
+        self.mask = mask
+
+    @classmethod
+    def _from_iterable(cls, cards: Iterable[Card]) -> "CardSet":
+        mask = 0
+        for card in cards:
+            mask |= 1 << card_code(card)
+        return cls(mask)
+
+    def __contains__(self, card) -> bool:
+        return self.mask & CARD_BITS.get(card, 0) != 0
+
+    def __iter__(self) -> Iterator[Card]:
+        mask = self.mask
+        for code in range(NUM_CARD_TYPES):
+            if mask >> code & 1:
+                yield CARDS[code]
+
+    def __len__(self) -> int:
+        return bin(self.mask).count("1")
+
+    def __repr__(self) -> str:
+        return f"CardSet({set(self)})"
+
+
+class DiscardPile(Mapping):
+    """Read-only mapping from card to number of discarded copies"""
+
+    __slots__ = ("counts",)
+
+    def __init__(self, counts: list) -> None:
+        self.counts = counts
+
+    def __getitem__(self, card) -> int:
+        return self.counts[card_code(card)]
+
+    def __iter__(self) -> Iterator[Card]:
+        return iter(CARDS)
+
+    def __len__(self) -> int:
+        return NUM_CARD_TYPES
+
+
+class PackedBoard(Board):
+    """
+    Board with compact card bookkeeping. The card sets are exposed as CardSet
+    views and the discard pile as a DiscardPile view, so agents written
+    against Board run unmodified.
+    """
+
+    def _init_card_state(self) -> None:
+        """Initialize the discard counts and card masks"""
+
+        self._discards = [0] * NUM_CARD_TYPES
+        self._reset_card_state()
+
+    def _reset_card_state(self) -> None:
+        """Clear the discard counts in place and reset the card masks"""
+
+        self._discards[:] = EMPTY_COUNTS
+        self._played = 0
+        self._dead = 0
+        self._useless = 0
+        self._critical = FIVES_MASK
+        self._playable = ONES_MASK
+
+    def _snapshot_card_state(self) -> tuple:
+        """Copy of the discard counts and the card masks"""
+
+        return (
+            self._discards[:],
+            self._played,
+            self._dead,
+            self._useless,
+            self._critical,
+            self._playable,
+        )
+
+    def _restore_card_state(self, card_state: tuple) -> None:
+        """Return the discard counts and card masks to a snapshot"""
+
+        (
+            discards,
+            self._played,
+            self._dead,
+            self._useless,
+            self._critical,
+            self._playable,
+        ) = card_state
+        self._discards[:] = discards
+
+    def play(self, player_id: int, target: int, colour: int) -> Action:
+        """Resolve a move where player_id plays a card from its hand."""
+
+        # Remove card from player's hand
+        card = self.remove(player_id, target)
+        self.draw(player_id)
+        action = (PLAY, card, colour)
+        code = card_code(card)
+        bit = CARD_BITS[card]
+
+        # If card is illegal, discard with strike
+        if card.colour != colour or not self._playable & bit:
+            self.num_strikes += 1
+            self._add_code_to_discard_pile(code)
+            return action
+
+        # Play the card and make the next card of the firework playable
+        self.fireworks[colour] += 1
+        self._played |= bit
+        self._useless |= bit
+        self._playable &= ~bit
+        if card.rank < FIVE:
+            self._playable |= bit << 1
+        self.score += 1
+
+        if self.score == 25:
+            self.game_over = True
+
+        # A played card is never critical
+        self._critical &= ~bit
+
+        # A hint is obtained if the firework is completed
+        if card.rank == FIVE and self.num_hints < self.MAXHINTS:
+            self.num_hints += 1
+
+        return action
+
+    def discard(self, player_id: int, target: int) -> Action:
+        """Discard a card"""
+
+        # remove card from player hand and draw new card
+        card = self.remove(player_id, target)
+        self.draw(player_id)
+
+        # move card onto discard pile
+        self._add_code_to_discard_pile(card_code(card))
+        self.total_discarded += 1
+
+        return (DISCARD, card, 0)
+
+    def add_to_discard_pile(self, card: Card) -> None:
+        """Move a discarded or misplayed card onto the discard pile"""
+        self._add_code_to_discard_pile(card_code(card))
+
+    def _add_code_to_discard_pile(self, code: int) -> None:
+        """Move a card, given by its code, onto the discard pile"""
+
+        self._discards[code] += 1
+
+        # copies of played or dead cards do not change critical and dead cards
+        if self._useless >> code & 1:
+            return
+
+        # account for critical and dead cards after discard
+        num_left = CODECOUNTS[code] - self._discards[code]
+        if num_left == 1:
+            self._critical |= 1 << code
+
+        elif num_left == 0:
+            dead = RUN_MASKS[code]
+            self._critical &= ~dead
+            self._dead |= dead
+            self._useless |= dead
+
+    def is_playable(self, card: Card) -> bool:
+        """Whether a card can be played on the fireworks right now"""
+        return self._playable & CARD_BITS[card] != 0
+
+    def is_useless(self, card: Card) -> bool:
+        """Whether a card has been played or can no longer be played"""
+        return self._useless & CARD_BITS[card] != 0
+
+    def is_critical(self, card: Card) -> bool:
+        """Whether a card is the last copy still needed"""
+        return self._critical & CARD_BITS[card] != 0
+
+    def is_dead(self, card: Card) -> bool:
+        """Whether a card can no longer be played"""
+        return self._dead & CARD_BITS[card] != 0
+
+    @property
+    def max_score(self) -> int:
+        """Highest score still reachable given the dead cards"""
+        return NUM_CARD_TYPES - bin(self._dead).count("1")
+
+    @property
+    def discard_counts(self) -> list:
+        """Number of discarded copies per card code, without copying"""
+        return self._discards
+
+    @property
+    def discard_pile(self) -> DiscardPile:
+        """Number of discarded copies per card"""
+        return DiscardPile(self._discards)
+
+    @property
+    def played_cards(self) -> CardSet:
+        """Set of all played cards"""
+        return CardSet(self._played)
+
+    @property
+    def dead_cards(self) -> CardSet:
+        """Set of cards that can no longer be played"""
+        return CardSet(self._dead)
+
+    @property
+    def useless_cards(self) -> CardSet:
+        """Set of cards that have been played or are dead"""
+        return CardSet(self._useless)
+
+    @property
+    def critical_cards(self) -> CardSet:
+        """Set of cards of which only one copy is left"""
+        return CardSet(self._critical)
+
+    @property
+    def playable_cards(self) -> CardSet:
+        """Returns a set of all playable cards"""
+        return CardSet(self._playable)
@@ -0,0 +1,191 @@
+"""
+Replay of logged games without agents.
+
+A game is determined by its deck and its action log, see hanasim.actionlog.
+replay re-executes the logged moves through resolve_move on a reused board,
+so archived games can be re-scored far faster than by playing them with the
+agents again. verify also checks that the replayed log equals the stored one,
+e.g. to make sure across a stored corpus that an engine change does not alter
+any outcome. From the command line:
+
+    python -m hanasim.replay logs.bin --players 5 --decks decks.bin
+    python -m hanasim.replay logs.bin --players 5 --seed 0 --verify
+    python -m hanasim.replay logs.bin --players 5 --seed 0 --hanab-live 17 42
+
+Decks are read from the corpus the games were played on, or generated from
+the seed of their sweep.
+"""
+
+import argparse
+import sys
+from functools import partial
+from typing import Callable, Iterable, Iterator, List, Optional, Tuple
+
+from hanasim.actionlog import dumps_hanab_live, read_logs
+from hanasim.corpus import DeckCorpus
+from hanasim.hanasim import (
+    Action,
+    Board,
+    Card,
+    DISCARD,
+    ENDGAME,
+    PLAY,
+    decode_action,
+)
+from hanasim.native import BACKENDS, DEFAULT_BACKEND
+from hanasim.seeding import game_deck
+from hanasim.stats import ScoreStats
+
+DeckSource = Callable[[int], List[Card]]
+
+
+def logged_move(record: int) -> Tuple[int, Action]:
+    """Player and move of a play, discard or hint record"""
+
+    action_type, player, target, value, slot = decode_action(record)
+    if action_type == PLAY:
+        return player, (PLAY, slot, value)
+    if action_type == DISCARD:
+        return player, (DISCARD, slot, 0)
+    return player, (action_type, target, value)
+
+
+def replay(game: Board, deck: List[Card], records: Iterable[int]) -> Board:
+    """
+    Reset game with deck and play the logged moves up to the game over
+    record. Raises ValueError on a move the engine rejects.
+    """
+
+    game.reset(deck)
+    game.setup()
+    num_players = game.num_players
+
+    for record in records:
+        if record & 7 == ENDGAME:
+            break
+        player, move = logged_move(record)
+        if player != game.turn % num_players:
+            raise ValueError(f"Player {player} moves out of turn {game.turn}")
+        game.resolve_move(player, move)
+
+    return game
+
+
+def verify(game: Board, deck: List[Card], records) -> Optional[str]:
+    """
+    Replay a logged game. Returns how the replay differs from the log, or
+    None if the engine logs exactly the stored records.
+    """
+
+    try:
+        replay(game, deck, records)
+    except ValueError as error:
+        return f"rejected move: {error}"
+
+    replayed = game.action_log.view().tolist()
+    logged = list(records)
+    if replayed == logged:
+        return None
+
+    index = next(
+        (i for i, (a, b) in enumerate(zip(replayed, logged)) if a != b),
+        min(len(replayed), len(logged)),
+    )
+    return (
+        f"record {index} differs: replayed "
+        f"{decode_action(replayed[index]) if index < len(replayed) else None}, "
+        f"logged {decode_action(logged[index]) if index < len(logged) else None}"
+    )
+
+
+def replay_logs(
+    path: str,
+    num_players: int,
+    decks: DeckSource,
+    board_class=BACKENDS[DEFAULT_BACKEND],
+) -> Iterator[Tuple[int, Board]]:
+    """
+    Replay every game of a log file on one reused board, yielding the game
+    index and the finished board, which is only valid until the next game.
+    """
+
+    game = board_class(num_players)
+    for game_index, records in read_logs(path):
+        yield game_index, replay(game, decks(game_index), records)
+
+
+def verify_logs(
+    path: str,
+    num_players: int,
+    decks: DeckSource,
+    board_class=BACKENDS[DEFAULT_BACKEND],
+) -> Iterator[Tuple[int, Optional[str], Board]]:
+    """
+    Verify every game of a log file on one reused board, yielding the game
+    index, the difference and the replayed board, which is only valid until
+    the next game.
+    """
+
+    game = board_class(num_players)
+    for game_index, records in read_logs(path):
+        yield game_index, verify(game, decks(game_index), records), game
+
+
+def deck_source(corpus_path: str = None, seed: int = 0) -> DeckSource:
+    """Decks by game index, from a corpus file or a seeded sweep"""
+
+    if corpus_path:
+        return DeckCorpus(corpus_path).deck
+    return partial(game_deck, seed)
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="Replay logged games")
+    parser.add_argument("logs", help="log file written by hanasim.actionlog")
+    parser.add_argument("--players", type=int, required=True)
+    parser.add_argument("--decks", help="deck corpus the games were played on")
+    parser.add_argument("--seed", type=int, default=0, help="seed of the sweep")
+    parser.add_argument(
+        "--backend", choices=list(BACKENDS), default=DEFAULT_BACKEND
+    )
+    parser.add_argument(
+        "--verify",
+        action="store_true",
+        help="check that the engine reproduces every logged record",
+    )
+    parser.add_argument(
+        "--hanab-live",
+        type=int,
+        nargs="+",
+        metavar="GAME",
+        help="print the hanab.live JSON of these games instead, one per line",
+    )
+    args = parser.parse_args()
+
+    decks = deck_source(args.decks, args.seed)
+    board_class = BACKENDS[args.backend]
+
+    if args.hanab_live:
+        wanted = set(args.hanab_live)
+        for game_index, records in read_logs(args.logs):
+            if game_index in wanted:
+                print(dumps_hanab_live(decks(game_index), records, args.players))
+        sys.exit(0)
+
+    stats = ScoreStats()
+    if args.verify:
+        mismatches = 0
+        verified = verify_logs(args.logs, args.players, decks, board_class)
+        for game_index, difference, game in verified:
+            stats.add_game(game)
+            if difference is not None:
+                mismatches += 1
+                if mismatches <= 10:
+                    print(f"game {game_index}: {difference}", file=sys.stderr)
+        print(stats.summary())
+        print(f"{mismatches} of {stats.count} games differ from their logs")
+        sys.exit(1 if mismatches else 0)
+
+    for _, game in replay_logs(args.logs, args.players, decks, board_class):
+        stats.add_game(game)
+    print(stats.summary())
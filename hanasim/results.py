@@ -0,0 +1,76 @@
+"""
+Per-game results shared between the simulation driver and its pool workers.
+
+Workers write the outcome of every game straight into a structured NumPy array
+backed by multiprocessing.shared_memory, so the driver reads the results
+without pickling or copying them.
+"""
+
+from multiprocessing import shared_memory
+
+import numpy as np
+
+from hanasim.hanasim import Board
+
+# Layout of the result record of a single game
+RESULT_DTYPE = np.dtype(
+    [
+        ("score", np.uint8),
+        ("strikes", np.uint8),
+        ("turns", np.uint16),
+        ("hints", np.uint8),
+    ]
+)
+
+
+def record(game: Board) -> tuple:
+    """Result record of a finished game"""
+    return (game.score, game.num_strikes, game.turn, game.num_hints)
+
+
+class SharedResults:
+    """
+    Structured array of RESULT_DTYPE records in shared memory. The driver
+    creates the block and unlinks it when done, workers attach to it by name.
+    """
+
+    def __init__(self, shm: shared_memory.SharedMemory, num_games: int) -> None:
+        """Wrap an existing shared memory block, use create or attach instead"""
+
+        self.shm = shm
+        self.num_games = num_games
+        self.array = np.ndarray((num_games,), dtype=RESULT_DTYPE, buffer=shm.buf)
+
+    @classmethod
+    def create(cls, num_games: int) -> "SharedResults":
+        """Allocate a zeroed result block for num_games games"""
+
+        size = max(num_games * RESULT_DTYPE.itemsize, 1)
+        shared = cls(shared_memory.SharedMemory(create=True, size=size), num_games)
+        shared.array[:] = 0
+        return shared
+
+    @classmethod
+    def attach(cls, name: str, num_games: int) -> "SharedResults":
+        """Attach to a result block created by another process"""
+        return cls(shared_memory.SharedMemory(name=name), num_games)
+
+    @property
+    def name(self) -> str:
+        """Name under which workers can attach to the block"""
+        return self.shm.name
+
+    def close(self) -> None:
+        """Release this process' view of the block"""
+
+        self.array = None
+        self.shm.close()
+
+    def __enter__(self) -> "SharedResults":
+        return self
+
+    def __exit__(self, *exc) -> None:
+        """Close and unlink the block, to be used by the creating process"""
+
+        self.close()
+        self.shm.unlink()
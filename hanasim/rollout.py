@@ -0,0 +1,212 @@
+"""
+Determinized Monte Carlo rollouts from the point of view of one player.
+
+A player does not see its own hand. Rollouts.evaluate samples decks that are
+consistent with what the observer sees: the cards in other hands, on the
+fireworks and in the discard pile stay where they are, and the unseen cards,
+the observer's hand and the rest of the deck, are dealt at random over the
+unseen positions. Slot masks of the cards each slot can still hold, such as
+the hint knowledge in Board.slot_masks, restrict the sampled hand, and
+the counts of the cards in the hands follow the sampled deck. Every legal
+action of the observer is then played on each sample and the game is rolled
+out with a policy, giving the mean final score, or another value of the
+finished game, per action.
+
+The board is searched in place with snapshot and restore, the players are
+detached while rolling out and the sampled deck is a buffer reused between
+samples. ActionValues of independent evaluations, e.g. on several workers
+with different seeds, merge into one estimate.
+"""
+
+import random
+from typing import Callable, Dict, Iterable, List, Optional
+
+from hanasim.hanasim import Action, Board, Card, card_code
+
+Policy = Callable[[Board, int], Action]
+
+
+def final_score(game: Board) -> float:
+    """Default value of a rolled out game"""
+    return game.score
+
+
+class ActionValues:
+    """Sum and number of rollout scores per action index"""
+
+    def __init__(self) -> None:
+        self.totals: Dict[int, float] = {}
+        self.counts: Dict[int, int] = {}
+
+    def add(self, action: int, score: float) -> None:
+        self.totals[action] = self.totals.get(action, 0.0) + score
+        self.counts[action] = self.counts.get(action, 0) + 1
+
+    def merge(self, other: "ActionValues") -> "ActionValues":
+        """Add the rollouts of another evaluation of the same position"""
+
+        for action, total in other.totals.items():
+            self.totals[action] = self.totals.get(action, 0.0) + total
+            self.counts[action] = self.counts.get(action, 0) + other.counts[action]
+        return self
+
+    def value(self, action: int) -> float:
+        """Mean rollout score of an action"""
+        return self.totals[action] / self.counts[action]
+
+    def values(self) -> Dict[int, float]:
+        return {action: self.value(action) for action in self.totals}
+
+    def best(self) -> int:
+        """Action with the highest mean score, the first evaluated on ties"""
+        return max(self.totals, key=self.value)
+
+
+def agent_policy(agent_module) -> Policy:
+    """Policy playing the moves of an agent module, one agent per player"""
+
+    agents = {}
+
+    def policy(game: Board, player_id: int) -> Action:
+        agent = agents.get(player_id)
+        if agent is None:
+            agent = agents[player_id] = agent_module.Agent(player_id, game)
+        return agent.find_move(game)
+
+    return policy
+
+
+class Rollouts:
+    """
+    Determinized rollout engine. The sampling buffers are kept between
+    evaluations, so one engine serves every decision of an agent.
+    """
+
+    def __init__(
+        self,
+        policy: Policy,
+        rng: random.Random = None,
+        value: Callable[[Board], float] = final_score,
+    ) -> None:
+        self.policy = policy
+        self.value = value
+        self.rng = rng if rng is not None else random.Random()
+        self.deck: List[Card] = []
+        self.positions: List[int] = []
+        self.pool: List[Card] = []
+
+    def prepare(self, game: Board, observer: int) -> None:
+        """Collect the unseen positions and cards of the observer"""
+
+        self.deck[:] = game.deck
+        self.positions[:] = game.player_hands[observer]
+        self.positions.extend(range(game.index, len(game.deck)))
+        self.pool[:] = [game.deck[position] for position in self.positions]
+
+    def sample(self, slot_masks: Optional[List[int]] = None) -> List[Card]:
+        """
+        Deal the unseen cards over the unseen positions of the prepared
+        board. If slot_masks are given, the card of hand slot i is drawn from
+        the unseen cards whose code bit is set in slot_masks[i], raising
+        ValueError if no deal matches every mask. The slots take the first
+        matching cards of a shuffle, so the sample is only approximately
+        uniform over the consistent deals.
+        """
+
+        pool = self.pool
+        rng = self.rng
+        rng.shuffle(pool)
+
+        if slot_masks is not None and not self.fill(slot_masks):
+            raise ValueError("No deal of the unseen cards matches the slot masks")
+
+        deck = self.deck
+        for position, card in zip(self.positions, pool):
+            deck[position] = card
+        return deck
+
+    def fill(self, slot_masks: List[int]) -> bool:
+        """
+        Move a matching card of the shuffled pool into every slot, the card
+        of slot i to pool[i], returning False if there is no such deal. A card
+        taken by an earlier slot is traded for another match of that slot
+        when a later slot needs it.
+        """
+
+        pool = self.pool
+        codes = [card_code(card) for card in pool]
+        owners: Dict[int, int] = {}
+
+        def assign(slot: int, seen: set) -> bool:
+            mask = slot_masks[slot]
+            for i, code in enumerate(codes):
+                if mask >> code & 1 and i not in seen:
+                    seen.add(i)
+                    if i not in owners or assign(owners[i], seen):
+                        owners[i] = slot
+                        return True
+            return False
+
+        for slot in range(len(slot_masks)):
+            if not assign(slot, set()):
+                return False
+
+        hand = [None] * len(slot_masks)
+        for i, slot in owners.items():
+            hand[slot] = pool[i]
+        pool[:] = hand + [card for i, card in enumerate(pool) if i not in owners]
+        return True
+
+    def rollout(self, game: Board) -> float:
+        """Play the game to the end with the policy, returning its value"""
+
+        policy = self.policy
+        while not game.game_over:
+            player_id = game.turn % game.num_players
+            game.resolve_move(player_id, policy(game, player_id))
+        return self.value(game)
+
+    def evaluate(
+        self,
+        game: Board,
+        observer: int,
+        num_samples: int,
+        actions: Iterable[int] = None,
+        slot_masks: Optional[List[int]] = None,
+    ) -> ActionValues:
+        """
+        Estimate the value of the observer's actions, by default all legal
+        ones, with num_samples determinized rollouts each. All actions are
+        evaluated on the same samples. The board is left as it was found.
+        """
+
+        if game.turn % game.num_players != observer:
+            raise ValueError(f"It is not the turn of player {observer}")
+
+        if actions is None:
+            legal = game.legal_actions(observer)
+            actions = [i for i in range(game.num_actions) if legal >> i & 1]
+        else:
+            actions = list(actions)
+
+        values = ActionValues()
+        state = game.snapshot()
+        players = list(game.players)
+        for player_id in range(game.num_players):
+            game.set_player(None, player_id)
+        self.prepare(game, observer)
+
+        try:
+            for _ in range(num_samples):
+                deck = self.sample(slot_masks)
+                for action in actions:
+                    game.replace_deck(deck)
+                    game.resolve_move(observer, game.action_to_move(observer, action))
+                    values.add(action, self.rollout(game))
+                    game.restore(state)
+        finally:
+            for player_id, player in enumerate(players):
+                game.set_player(player, player_id)
+            game.restore(state)
+
+        return values
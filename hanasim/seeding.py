@@ -0,0 +1,45 @@
+"""
+Deterministic per-game random streams.
+
+Every game of a sweep is identified by a (seed, game_index) pair. The deck of
+a game only depends on that pair, never on how games are chunked over workers
+or in which order they run, so strategies can be compared on common decks.
+"""
+
+from typing import List
+
+import numpy as np
+
+from hanasim.hanasim import Card, DECK, card_code, shuffled_deck
+
+# Card codes of the unshuffled deck
+DECK_CODES = np.array([card_code(card) for card in DECK], dtype=np.int8)
+
+
+def game_seed(seed: int, game_index: int) -> np.random.SeedSequence:
+    """
+    Seed sequence of a game, identical to SeedSequence(seed).spawn(n)[game_index]
+    without spawning the preceding children.
+    """
+    return np.random.SeedSequence(seed, spawn_key=(game_index,))
+
+
+def game_rng(seed: int, game_index: int) -> np.random.Generator:
+    """Random generator of a game"""
+    return np.random.default_rng(game_seed(seed, game_index))
+
+
+def game_deck(seed: int, game_index: int) -> List[Card]:
+    """Shuffled deck of a game"""
+    return shuffled_deck(game_rng(seed, game_index))
+
+
+def game_decks(seed: int, start: int, count: int) -> np.ndarray:
+    """Card codes of the decks of games start to start + count, one per row"""
+
+    decks = np.empty((count, len(DECK)), dtype=np.int8)
+    for row in range(count):
+        rng = game_rng(seed, start + row)
+        decks[row] = DECK_CODES[rng.permutation(len(DECK))]
+
+    return decks
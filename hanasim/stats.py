@@ -0,0 +1,284 @@
+"""
+Streaming statistics of simulated games.
+
+ScoreStats aggregates game results online: mean and variance of the score with
+Welford's algorithm, histograms of scores and turn counts, and strike-out and
+perfect game counts. Workers aggregate their chunks locally and the driver
+merges the partial aggregates, so no per-game results need to be kept.
+PairedStats compares two agents on the same decks through the moments of the
+per-deck score difference. Aggregates convert to and from plain dicts, e.g.
+to checkpoint them as JSON.
+"""
+
+import math
+from typing import Any, Dict, List, Tuple
+
+from hanasim.hanasim import Board, COLOURS, MAXRECORDS, RANKS
+
+MAXSCORE = len(COLOURS) * len(RANKS)
+
+
+class Moments:
+    """Running count, mean and variance of a sample (Welford)"""
+
+    def __init__(self) -> None:
+        self.count = 0
+        self.mean = 0.0
+        self.m2 = 0.0
+
+    def update(self, value: float) -> None:
+        """Add one observation"""
+
+        self.count += 1
+        delta = value - self.mean
+        self.mean += delta / self.count
+        self.m2 += delta * (value - self.mean)
+
+    def merge(self, other: "Moments") -> "Moments":
+        """Combine with the moments of a disjoint sample (Chan et al.)"""
+
+        count = self.count + other.count
+        if count == 0:
+            return self
+
+        delta = other.mean - self.mean
+        self.m2 += other.m2 + delta * delta * self.count * other.count / count
+        self.mean += delta * other.count / count
+        self.count = count
+        return self
+
+    @property
+    def variance(self) -> float:
+        """Sample variance"""
+        return self.m2 / (self.count - 1) if self.count > 1 else 0.0
+
+    @property
+    def std(self) -> float:
+        return math.sqrt(self.variance)
+
+    @property
+    def stderr(self) -> float:
+        """Standard error of the mean, unbounded below two observations"""
+        return math.sqrt(self.variance / self.count) if self.count > 1 else math.inf
+
+    def ci_halfwidth(self, z: float = 1.96) -> float:
+        """Half width of the normal confidence interval of the mean"""
+        return z * self.stderr
+
+    def to_dict(self) -> Dict[str, Any]:
+        """State of the aggregate as a dict of plain values, see stats_from_dict"""
+        return {
+            "kind": type(self).__name__,
+            "count": self.count,
+            "mean": self.mean,
+            "m2": self.m2,
+        }
+
+    def _load(self, state: Dict[str, Any]) -> None:
+        self.count = state["count"]
+        self.mean = state["mean"]
+        self.m2 = state["m2"]
+
+
+class ScoreStats(Moments):
+    """Online aggregate of game results"""
+
+    def __init__(self) -> None:
+        super().__init__()
+        self.strikeouts = 0
+        self.score_hist = [0] * (MAXSCORE + 1)
+        self.turn_hist = [0] * MAXRECORDS
+
+    def update(self, score: int, strikes: int, turns: int) -> None:
+        """Add the result of one game"""
+
+        super().update(score)
+        self.score_hist[score] += 1
+        self.turn_hist[min(turns, MAXRECORDS - 1)] += 1
+        if strikes >= Board.MAXSTRIKES:
+            self.strikeouts += 1
+
+    def add_game(self, game: Board) -> None:
+        """Add the result of a finished game"""
+        self.update(game.score, game.num_strikes, game.turn)
+
+    def to_dict(self) -> Dict[str, Any]:
+        state = super().to_dict()
+        state["strikeouts"] = self.strikeouts
+        state["score_hist"] = list(self.score_hist)
+        state["turn_hist"] = list(self.turn_hist)
+        return state
+
+    def _load(self, state: Dict[str, Any]) -> None:
+        super()._load(state)
+        self.strikeouts = state["strikeouts"]
+        self.score_hist = list(state["score_hist"])
+        self.turn_hist = list(state["turn_hist"])
+
+    def merge(self, other: "ScoreStats") -> "ScoreStats":
+        """Combine with the aggregate of a disjoint set of games"""
+
+        super().merge(other)
+        self.strikeouts += other.strikeouts
+        self.score_hist = [a + b for a, b in zip(self.score_hist, other.score_hist)]
+        self.turn_hist = [a + b for a, b in zip(self.turn_hist, other.turn_hist)]
+        return self
+
+    @property
+    def strikeout_rate(self) -> float:
+        return self.strikeouts / self.count if self.count else 0.0
+
+    @property
+    def perfect_rate(self) -> float:
+        return self.score_hist[MAXSCORE] / self.count if self.count else 0.0
+
+    def quantile(self, q: float, hist: List[int] = None) -> int:
+        """Smallest value whose cumulative frequency reaches q"""
+
+        hist = self.score_hist if hist is None else hist
+        target = q * self.count
+        total = 0
+        for value, frequency in enumerate(hist):
+            total += frequency
+            if total >= target and total > 0:
+                return value
+        return len(hist) - 1
+
+    def progress(self) -> str:
+        """One line summary for live progress reports"""
+        return (
+            f"{self.count} games, score {self.mean:.3f} "
+            f"± {self.ci_halfwidth():.3f}, "
+            f"perfect {100 * self.perfect_rate:.1f}%, "
+            f"strike-outs {100 * self.strikeout_rate:.1f}%"
+        )
+
+    def summary(self) -> str:
+        """Multi-line report of the aggregate"""
+
+        lines = [
+            f"games          {self.count}",
+            f"mean score     {self.mean:.4f} ± {self.ci_halfwidth():.4f} (95%)",
+            f"std            {self.std:.4f}",
+            f"quartiles      {self.quantile(0.25)} {self.quantile(0.5)} "
+            f"{self.quantile(0.75)}",
+            f"perfect games  {100 * self.perfect_rate:.2f}%",
+            f"strike-outs    {100 * self.strikeout_rate:.2f}%",
+            f"turns median   {self.quantile(0.5, self.turn_hist)}",
+            "score histogram:",
+        ]
+        peak = max(self.score_hist) or 1
+        for score, frequency in enumerate(self.score_hist):
+            if frequency:
+                bar = "#" * max(1, round(40 * frequency / peak))
+                lines.append(f"  {score:>2} {frequency:>10} {bar}")
+        return "\n".join(lines)
+
+
+class PairedStats(Moments):
+    """
+    Aggregate of two agents playing the same decks. The moments are those of
+    the per-deck score difference, first minus second, whose variance is
+    usually far below that of either score since both share the deck luck.
+    """
+
+    def __init__(self) -> None:
+        super().__init__()
+        self.first = ScoreStats()
+        self.second = ScoreStats()
+
+    def add_games(self, first: Board, second: Board) -> None:
+        """Add the results of both agents on one deck"""
+
+        self.first.add_game(first)
+        self.second.add_game(second)
+        self.update(first.score - second.score)
+
+    def merge(self, other: "PairedStats") -> "PairedStats":
+        """Combine with the aggregate of a disjoint set of decks"""
+
+        super().merge(other)
+        self.first.merge(other.first)
+        self.second.merge(other.second)
+        return self
+
+    def to_dict(self) -> Dict[str, Any]:
+        state = super().to_dict()
+        state["first"] = self.first.to_dict()
+        state["second"] = self.second.to_dict()
+        return state
+
+    def _load(self, state: Dict[str, Any]) -> None:
+        super()._load(state)
+        self.first = stats_from_dict(state["first"])
+        self.second = stats_from_dict(state["second"])
+
+    def progress(self) -> str:
+        """One line summary for live progress reports"""
+        return (
+            f"{self.count} decks, difference {self.mean:+.3f} "
+            f"± {self.ci_halfwidth():.3f}, "
+            f"scores {self.first.mean:.3f} vs {self.second.mean:.3f}"
+        )
+
+    def summary(self) -> str:
+        """Report of both aggregates and their paired difference"""
+
+        return "\n".join(
+            [
+                "first agent:",
+                self.first.summary(),
+                "second agent:",
+                self.second.summary(),
+                f"difference     {self.mean:+.4f} ± {self.ci_halfwidth():.4f} (95%)",
+                f"std            {self.std:.4f}",
+            ]
+        )
+
+
+def stats_from_dict(state: Dict[str, Any]) -> Moments:
+    """Aggregate of the kind stored by its to_dict method"""
+
+    kinds = {cls.__name__: cls for cls in (Moments, ScoreStats, PairedStats)}
+    if state.get("kind") not in kinds:
+        raise ValueError(f"Unknown aggregate kind {state.get('kind')!r}")
+    stats = kinds[state["kind"]]()
+    stats._load(state)
+    return stats
+
+
+def results_table(cells: Dict[Tuple[str, int], ScoreStats]) -> str:
+    """Table of aggregates keyed by agent name and player count"""
+
+    rows = [
+        (
+            agent,
+            str(num_players),
+            str(stats.count),
+            f"{stats.mean:.3f} ± {stats.ci_halfwidth():.3f}",
+            f"{stats.std:.3f}",
+            f"{100 * stats.perfect_rate:.2f}",
+            f"{100 * stats.strikeout_rate:.2f}",
+            str(stats.quantile(0.5, stats.turn_hist)),
+        )
+        for (agent, num_players), stats in cells.items()
+    ]
+    header = (
+        "agent",
+        "players",
+        "games",
+        "mean score",
+        "std",
+        "perfect %",
+        "strike-out %",
+        "turns",
+    )
+    widths = [max(len(row[i]) for row in [header] + rows) for i in range(len(header))]
+
+    lines = []
+    for row in [header] + rows:
+        cols = [row[0].ljust(widths[0])] + [
+            col.rjust(width) for col, width in zip(row[1:], widths[1:])
+        ]
+        lines.append("  ".join(cols))
+    return "\n".join(lines)
@@ -0,0 +1,216 @@
+"""
+Opt-in per-turn telemetry, stored as partitioned Parquet files.
+
+record_turns() derives a Board subclass that appends the state before every
+move to a TurnRecorder: game index, turn, player, action type, hint tokens,
+strikes, pace and score. Recorders keep their columns in typed arrays and
+hand them to Arrow as record batches without a copy, so recording costs a few
+appends per turn and no Python objects. A TelemetrySink holds a recorder per
+(agent, player count) and writes a chunk of games to one Parquet file per
+recorder, in a Hive-style layout that notebooks read column by column:
+
+    telemetry/agent=cheat_tobin/players=5/part-000000001000.parquet
+
+Files are named by their chunk's first game, so chunks played again after a
+restart overwrite their files. Writing needs pyarrow; recording does not.
+"""
+
+import os
+from array import array
+from typing import Dict, List, Tuple
+
+from hanasim.hanasim import Board
+
+try:
+    import pyarrow as pa
+    import pyarrow.dataset as ds
+    import pyarrow.parquet as pq
+
+    ARROW = True
+except ImportError:
+    ARROW = False
+
+# Column name and array typecode of every recorded field
+COLUMNS = [
+    ("game", "Q"),
+    ("turn", "H"),
+    ("player", "B"),
+    ("action", "B"),
+    ("hints", "B"),
+    ("strikes", "B"),
+    ("pace", "b"),
+    ("score", "B"),
+]
+
+if ARROW:
+    ARROW_TYPES = {
+        "Q": pa.uint64(),
+        "H": pa.uint16(),
+        "B": pa.uint8(),
+        "b": pa.int8(),
+    }
+    SCHEMA = pa.schema([(name, ARROW_TYPES[code]) for name, code in COLUMNS])
+
+
+def require_arrow() -> None:
+    """Raise ImportError if pyarrow is missing"""
+
+    if not ARROW:
+        raise ImportError("Writing telemetry needs pyarrow")
+
+
+class TurnRecorder:
+    """
+    Per-turn columns of the games played on one board. Once path is set,
+    every batch_size turns are streamed to a Parquet file there.
+    """
+
+    def __init__(self, batch_size: int = 1 << 16) -> None:
+        self.batch_size = batch_size
+        self.game_index = 0
+        self.columns: List[array] = [array(code) for _, code in COLUMNS]
+        self.path = None
+        self.writer = None
+
+    def __len__(self) -> int:
+        return len(self.columns[0])
+
+    def record(self, game: Board, player_id: int, action_type: int) -> None:
+        """Append the state of game before player_id's move"""
+
+        values = (
+            self.game_index,
+            game.turn,
+            player_id,
+            action_type,
+            game.num_hints,
+            game.num_strikes,
+            game.pace,
+            game.score,
+        )
+        for column, value in zip(self.columns, values):
+            column.append(value)
+        if self.path is not None and len(self) >= self.batch_size:
+            self.write_batch()
+
+    def record_batch(self) -> "pa.RecordBatch":
+        """Arrow view of the recorded columns, valid until they are cleared"""
+
+        require_arrow()
+        arrays = [
+            pa.Array.from_buffers(
+                ARROW_TYPES[column.typecode], len(column), [None, pa.py_buffer(column)]
+            )
+            for column in self.columns
+        ]
+        return pa.RecordBatch.from_arrays(arrays, schema=SCHEMA)
+
+    def rows(self) -> List[Tuple[int, ...]]:
+        """Recorded turns as tuples, for tests and small samples"""
+        return list(zip(*self.columns))
+
+    def clear(self) -> None:
+        # Fresh arrays, buffers handed to Arrow may still be referenced
+        self.columns = [array(code) for _, code in COLUMNS]
+
+    def partial_path(self) -> str:
+        # Hidden from readers of the dataset until complete
+        head, tail = os.path.split(self.path)
+        return os.path.join(head, f".{tail}")
+
+    def write_batch(self) -> None:
+        """Stream the recorded turns to the file at path and clear them"""
+
+        if self.writer is None:
+            self.writer = pq.ParquetWriter(self.partial_path(), SCHEMA)
+        self.writer.write_batch(self.record_batch())
+        self.clear()
+
+    def close(self) -> None:
+        """
+        Write the remaining turns and move the complete file to path. Does
+        nothing if no turns were recorded since path was set.
+        """
+
+        if len(self):
+            self.write_batch()
+        if self.writer is not None:
+            self.writer.close()
+            self.writer = None
+            os.replace(self.partial_path(), self.path)
+        self.path = None
+
+
+def record_turns(board_class: type, recorder: TurnRecorder) -> type:
+    """Subclass of a board class that records every turn in recorder"""
+
+    class RecordedBoard(board_class):
+        def resolve_move(self, player, action_attempt):
+            recorder.record(self, player, action_attempt[0])
+            super().resolve_move(player, action_attempt)
+
+    RecordedBoard.__name__ = f"Recorded{board_class.__name__}"
+    return RecordedBoard
+
+
+class TelemetrySink:
+    """Recorders of a worker by (agent, player count), written per chunk"""
+
+    def __init__(self, directory: str, batch_size: int = 1 << 16) -> None:
+        require_arrow()
+        self.directory = directory
+        self.batch_size = batch_size
+        self.recorders: Dict[Tuple[str, int], TurnRecorder] = {}
+        self.game_index = 0
+        self.part = None
+
+    def recorder(self, agent: str, num_players: int) -> TurnRecorder:
+        key = (agent, num_players)
+        if key not in self.recorders:
+            recorder = self.recorders[key] = TurnRecorder(self.batch_size)
+            recorder.game_index = self.game_index
+            if self.part is not None:
+                recorder.path = self.part_path(key)
+        return self.recorders[key]
+
+    def part_path(self, key: Tuple[str, int]) -> str:
+        agent, num_players = key
+        partition = os.path.join(
+            self.directory, f"agent={agent}", f"players={num_players}"
+        )
+        os.makedirs(partition, exist_ok=True)
+        return os.path.join(partition, f"{self.part}.parquet")
+
+    def set_game(self, game_index: int) -> None:
+        """Index of the deck the following turns are played on"""
+
+        self.game_index = game_index
+        for recorder in self.recorders.values():
+            recorder.game_index = game_index
+
+    def start_chunk(self, first_game: int) -> None:
+        """Name the part files of the chunk after its first game"""
+
+        self.part = f"part-{first_game:012d}"
+        for key, recorder in self.recorders.items():
+            recorder.clear()
+            recorder.path = self.part_path(key)
+
+    def finish_chunk(self) -> None:
+        """Write the part files of the recorders that played in the chunk"""
+
+        for recorder in self.recorders.values():
+            recorder.close()
+        self.part = None
+
+
+def read_telemetry(directory: str, columns=None, filter=None) -> "pa.Table":
+    """
+    Read a telemetry directory as one table with agent and players columns,
+    only loading the given columns and the files matching filter, e.g.
+    ds.field("players") == 5.
+    """
+
+    require_arrow()
+    dataset = ds.dataset(directory, format="parquet", partitioning="hive")
+    return dataset.to_table(columns=columns, filter=filter)
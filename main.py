@@ -1,42 +1,703 @@
+import os
+import sys
 import time
-import random
-import multiprocessing
+import argparse
+import importlib
+from contextlib import nullcontext
 import pandas as pd
-import numpy as np
 import hanasim.hanasim as hs
+from hanasim.actionlog import LogWriter, pack_log
+from hanasim.checkpoint import Checkpoint
+from hanasim.batch import BatchBoard, play_batch
+from hanasim.native import BACKENDS, DEFAULT_BACKEND
+from hanasim.results import SharedResults, record
+from hanasim.seeding import game_deck
+from hanasim.corpus import DeckCorpus
+from hanasim.difficulty import DeckIndex, index_path
+from hanasim.executors import EXECUTORS, make_executor
+from hanasim.instrument import Counters, TimedAgent, instrument
+from hanasim.memory import MemoryCounters, TrackedAgent, track, traced
+from hanasim.stats import PairedStats, ScoreStats, results_table
+from hanasim.telemetry import ARROW, TelemetrySink, record_turns
 
-# import agents.cheater_discard_first as agent
-import agents.cheat_tobin as agent
+DEFAULT_AGENT = "agents.cheat_tobin"
 
+# Per-worker run state, set by init_worker
+agent_modules = []
+shared_results = None
+deck_corpus = None
+worker_board_class = BACKENDS[DEFAULT_BACKEND]
+worker_counters = None
+worker_telemetry = None
+worker_memory = None
+memory_interval = 0
+worker_games = 0
+worker_logs = None
 
-def play_game(num_players):
+# Boards and players reused for every game of a worker, by (agent, players)
+tables = {}
 
-    game = hs.Board(num_players)
-    game.generate_deck()
-    game.setup()
 
-    players = [agent.Agent(ii, game) for ii in range(num_players)]
+def load_agent(name):
+    """Import an agent module, given by module path or by its name in agents"""
+    return importlib.import_module(name if "." in name else f"agents.{name}")
 
-    while not game.game_over:
-        player_id = game.turn % num_players
-        action = players[player_id].find_move(game)
-        game.resolve_move(player_id, action)
 
-    return game.score
+def init_worker(
+    agent_names=(DEFAULT_AGENT,),
+    results_name=None,
+    num_games=0,
+    corpus_path=None,
+    profile=False,
+    backend=DEFAULT_BACKEND,
+    telemetry_dir=None,
+    memory=0,
+    action_logs=False,
+):
+    """
+    Set up a pool worker: import the agents, attach to the shared result block
+    if per-game results are kept, map the deck corpus if one is given, switch
+    on instrumentation of the chosen board backend, with a telemetry
+    directory per-turn recording, with a memory interval the tracing of the
+    allocations of every memory-th game and with action_logs the collection
+    of the action logs returned with every chunk.
+    """
 
+    global agent_modules, shared_results, deck_corpus
+    global worker_board_class, worker_counters, worker_telemetry
+    global worker_memory, memory_interval, worker_games, worker_logs
+    agent_modules = [load_agent(name) for name in agent_names]
+    tables.clear()
+    if results_name:
+        shared_results = SharedResults.attach(results_name, num_games)
+    if corpus_path:
+        deck_corpus = DeckCorpus(corpus_path)
+    board_class = BACKENDS[backend]
+    worker_counters = Counters() if profile else None
+    worker_memory = MemoryCounters() if memory else None
+    memory_interval = memory
+    worker_games = 0
+    if profile:
+        worker_board_class = instrument(board_class, worker_counters)
+    elif memory:
+        worker_board_class = track(board_class, worker_memory)
+    else:
+        worker_board_class = board_class
+    worker_telemetry = TelemetrySink(telemetry_dir) if telemetry_dir else None
+    worker_logs = bytearray() if action_logs else None
 
-if __name__ == "__main__":
-    random.seed(0)
-    N = 100000
-    num_players = 5
 
-    pool_obj = multiprocessing.Pool()
+def get_deck(seed, game_index):
+    """Deck of a game, read from the corpus if one is loaded"""
+
+    if deck_corpus is not None:
+        return deck_corpus.deck(game_index)
+    return game_deck(seed, game_index)
+
+
+def get_table(agent, num_players):
+    """Board and players of an agent, created on first use by the worker"""
+
+    key = (agent, num_players)
+    if key not in tables:
+        board_class = worker_board_class
+        name = agent.__name__.rsplit(".", 1)[-1]
+        if worker_telemetry is not None:
+            recorder = worker_telemetry.recorder(name, num_players)
+            board_class = record_turns(board_class, recorder)
+        game = board_class(num_players)
+        players = [agent.Agent(ii, game) for ii in range(num_players)]
+        for ii, player in enumerate(players):
+            game.set_player(player, ii)
+        if worker_counters is not None:
+            players = [TimedAgent(player, worker_counters) for player in players]
+        if worker_memory is not None:
+            players = [TrackedAgent(player, worker_memory, name) for player in players]
+        tables[key] = game, players
+    return tables[key]
+
+
+def play_game(num_players, deck, agent):
+    """
+    Play a deck on the worker's reused board and players. The returned board
+    is only valid until the next game of the same agent and player count.
+    """
+
+    game, players = get_table(agent, num_players)
+    game.reset(deck)
+    game.setup()
+    for player in players:
+        player.reset(game)
+    return hs.play_game(game, players)
+
+
+def play_deck(num_players, index, seed):
+    """Play one deck with every loaded agent, returning the finished games"""
+
+    global worker_games
+    tic = time.perf_counter()
+    deck = get_deck(seed, index)
+    if worker_counters is not None:
+        worker_counters.add("get_deck", time.perf_counter() - tic)
+    if worker_telemetry is not None:
+        worker_telemetry.set_game(index)
+
+    # Every agent plays the same deck, so differences between them cancel luck
     tic = time.perf_counter()
-    scores = np.array(
-        pool_obj.map(play_game, [num_players for _ in range(N)], chunksize=100)
+    if worker_memory is not None and worker_games % memory_interval == 0:
+        games = [
+            traced(worker_memory, play_game, num_players, deck, agent)
+            for agent in agent_modules
+        ]
+        worker_memory.sample_rss(worker_games)
+    else:
+        games = [play_game(num_players, deck, agent) for agent in agent_modules]
+    if worker_counters is not None:
+        worker_counters.add("game", time.perf_counter() - tic, len(games))
+    worker_games += 1
+    return games
+
+
+def start_chunk(start):
+    """
+    Clear the worker's counters and action logs, which are returned pickled
+    with each chunk, and start the chunk's telemetry files
+    """
+
+    if worker_logs is not None:
+        worker_logs.clear()
+    if worker_counters is not None:
+        worker_counters.clear()
+    if worker_memory is not None:
+        worker_memory.clear()
+    if worker_telemetry is not None:
+        worker_telemetry.start_chunk(start)
+
+
+def finish_chunk():
+    """
+    Write the chunk's telemetry files. Returns the chunk's counters, of time
+    or memory, or None if the worker is not profiled.
+    """
+
+    if worker_telemetry is not None:
+        worker_telemetry.finish_chunk()
+    return worker_counters if worker_counters is not None else worker_memory
+
+
+def chunk_logs():
+    """Packed action logs of the chunk's games, None unless collected"""
+    return bytes(worker_logs) if worker_logs is not None else None
+
+
+def play_games(chunk):
+    """
+    Play games start to stop with the loaded agent, or the two compared
+    agents, and aggregate their results, as a PairedStats when comparing. The
+    first agent's results are also written to the shared block if one is
+    attached. Returns the chunk's aggregate, its counters if profiled and the
+    first agent's action logs if collected.
+    """
+
+    start, stop, num_players, seed = chunk
+    paired = len(agent_modules) == 2
+    stats = PairedStats() if paired else ScoreStats()
+    results = shared_results.array if shared_results is not None else None
+    start_chunk(start)
+
+    for index in range(start, stop):
+        games = play_deck(num_players, index, seed)
+        if paired:
+            stats.add_games(*games)
+        else:
+            stats.add_game(games[0])
+        if results is not None:
+            results[index] = record(games[0])
+        if worker_logs is not None:
+            worker_logs.extend(pack_log(index, games[0].action_log.view()))
+
+    return stats, finish_chunk(), chunk_logs()
+
+
+def play_batch_games(chunk):
+    """
+    Play games start to stop in lockstep on a BatchBoard with the BatchAgent
+    of the loaded agent module. Returns the chunk's aggregate, no counters
+    and the action logs if collected.
+    """
+
+    start, stop, num_players, seed = chunk
+    start_chunk(start)
+    decks = deck_corpus.codes(start, stop) if deck_corpus is not None else None
+    batch = BatchBoard(stop - start, num_players, decks)
+    if decks is None:
+        batch.seed_decks(seed, start)
+    batch.setup()
+    play_batch(batch, agent_modules[0].BatchAgent())
+
+    stats = ScoreStats()
+    results = zip(
+        batch.score.tolist(), batch.num_strikes.tolist(), batch.turn.tolist()
     )
-    toc = time.perf_counter()
+    for score, strikes, turns in results:
+        stats.update(score, strikes, turns)
+
+    if worker_logs is not None:
+        for game in range(stop - start):
+            worker_logs.extend(pack_log(start + game, batch.game_log(game)))
+    return stats, None, chunk_logs()
+
+
+def play_tournament_games(chunk):
+    """
+    Play games start to stop with every loaded agent. Returns the chunk's
+    player count, one ScoreStats per agent and, if profiled, its counters.
+    """
+
+    start, stop, num_players, seed = chunk
+    stats = [ScoreStats() for _ in agent_modules]
+    start_chunk(start)
+
+    for index in range(start, stop):
+        games = play_deck(num_players, index, seed)
+        for agent_stats, game in zip(stats, games):
+            agent_stats.add_game(game)
+
+    return num_players, stats, finish_chunk()
+
+
+def play_chunk(task):
+    """Run a worker function on a chunk, returning the chunk with its result"""
+
+    worker, chunk = task
+    return chunk, worker(chunk)
+
 
-    df = pd.DataFrame({"Scores": scores})
+def report(results, index=None):
+    """
+    Print summary statistics of the results, viewed without copying. With
+    the difficulty records of their decks, also report the scores relative
+    to the decks' bounds, stratified by the lowest pace of the decks.
+    """
+
+    columns = {name: results[name] for name in results.dtype.names}
+    df = pd.DataFrame(columns, copy=False)
     print(df.describe())
-    print(f"Time elapsed: {1000*(toc-tic)} ms")
+
+    if index is not None:
+        df["bound"] = index["bound"]
+        df["min_pace"] = index["min_pace"]
+        print(f"score / bound  {df.score.sum() / df.bound.sum():.4f}")
+        strata = df.groupby("min_pace").agg(
+            games=("score", "size"), score=("score", "mean"), bound=("bound", "mean")
+        )
+        print(strata)
+
+
+def make_chunks(start, stop, chunksize, num_players, seed):
+    # The deck of game i only depends on (seed, i), not on the chunking
+    return [
+        (first, min(first + chunksize, stop), num_players, seed)
+        for first in range(start, stop, chunksize)
+    ]
+
+
+def merge_counters(counters, chunk_counters):
+    """
+    Merge a chunk's counters of time or memory into a copy of their type,
+    as the serial executor returns the worker's own counters
+    """
+
+    if chunk_counters is None:
+        return counters
+    if counters is None:
+        counters = type(chunk_counters)()
+    return counters.merge(chunk_counters)
+
+
+def run_chunks(
+    executor,
+    chunks,
+    stats=None,
+    counters=None,
+    progress_interval=0.5,
+    worker=play_games,
+    checkpoint=None,
+    logs=None,
+):
+    """
+    Play chunks on the executor with worker, play_games by default, and merge
+    their aggregates into stats as they complete, reporting progress on
+    stderr. The action logs returned with the chunks are appended to the
+    LogWriter logs, if given. Chunks completed in the checkpoint are merged
+    without playing them, the others are recorded as they complete. Returns
+    the merged aggregate and counters, None unless the workers are profiled.
+    """
+
+    last_report = time.perf_counter()
+
+    if checkpoint is not None:
+        for _, chunk_stats in checkpoint.done(chunks):
+            stats = chunk_stats if stats is None else stats.merge(chunk_stats)
+        chunks = checkpoint.pending(chunks)
+
+    tasks = [(worker, chunk) for chunk in chunks]
+    for chunk, (chunk_stats, chunk_counters, packed_logs) in executor.imap_unordered(
+        play_chunk, tasks
+    ):
+        # Logs go to disk first, a chunk is only recorded done with its logs
+        log_end = None
+        if logs is not None and packed_logs is not None:
+            logs.write_packed(packed_logs)
+            if checkpoint is not None:
+                logs.flush()
+                log_end = logs.tell()
+        if checkpoint is not None:
+            checkpoint.record(chunk, chunk_stats, log_end)
+        stats = chunk_stats if stats is None else stats.merge(chunk_stats)
+        counters = merge_counters(counters, chunk_counters)
+
+        now = time.perf_counter()
+        if now - last_report >= progress_interval:
+            print(f"\r{stats.progress()}", end="", file=sys.stderr, flush=True)
+            last_report = now
+
+    print(f"\r{stats.progress()}", file=sys.stderr)
+    return stats, counters
+
+
+def open_logs(path, checkpoint=None):
+    """
+    LogWriter appending to path. With a checkpoint the file is cut back to
+    the logs of the chunks it records, all of them for a new checkpoint, so
+    a resumed run holds the same logs as an uninterrupted one.
+    """
+
+    logs = LogWriter(path)
+    if checkpoint is not None:
+        logs.truncate(checkpoint.log_end)
+    return logs
+
+
+def run_sweep(executor, args, checkpoint=None, logs=None):
+    """
+    Play up to args.games games. With a target precision the games are played
+    in rounds of args.batch games, stopping once the 95% confidence interval
+    of the mean score, or of the paired difference when comparing agents, is
+    at most the target precision wide on either side. Rounds always cover
+    games 0 to n, so a sweep is reproducible for a given seed and batch size.
+    Vectorized sweeps play every chunk as one BatchBoard. Chunks completed
+    in the checkpoint, if given, are not played again. The action logs of
+    the games are appended to the LogWriter logs, if given.
+    """
+
+    stats, counters = None, None
+    batch = args.batch if args.precision else args.games
+    worker = play_batch_games if args.vectorized else play_games
+    played = 0
+
+    while played < args.games:
+        stop = min(played + batch, args.games)
+        chunks = make_chunks(
+            played, stop, args.chunksize, args.players[0], args.seed
+        )
+        stats, counters = run_chunks(
+            executor,
+            chunks,
+            stats,
+            counters,
+            worker=worker,
+            checkpoint=checkpoint,
+            logs=logs,
+        )
+        played = stop
+
+        if args.precision and stats.ci_halfwidth() <= args.precision:
+            break
+
+    return stats, counters
+
+
+def run_tournament(executor, args, checkpoint=None, progress_interval=0.5):
+    """
+    Play args.games decks per player count with every agent. The chunks of
+    all player counts are interleaved on the one executor and handed out as
+    workers free up, and each deck is played by all agents in the same task.
+    Chunks completed in the checkpoint, if given, are not played again.
+    Returns a ScoreStats per (agent, player count) and the merged counters.
+    """
+
+    cells = {
+        (agent, num_players): ScoreStats()
+        for agent in args.agent
+        for num_players in args.players
+    }
+    counters = None
+    chunks = [
+        (start, min(start + args.chunksize, args.games), num_players, args.seed)
+        for start in range(0, args.games, args.chunksize)
+        for num_players in args.players
+    ]
+
+    done = 0
+    if checkpoint is not None:
+        for (_, _, num_players, _), stats in checkpoint.done(chunks):
+            for agent, agent_stats in zip(args.agent, stats):
+                cells[agent, num_players].merge(agent_stats)
+            done += 1
+        chunks_left = checkpoint.pending(chunks)
+    else:
+        chunks_left = chunks
+    tasks = [(play_tournament_games, chunk) for chunk in chunks_left]
+
+    last_report = time.perf_counter()
+    for chunk, (num_players, stats, chunk_counters) in executor.imap_unordered(
+        play_chunk, tasks
+    ):
+        if checkpoint is not None:
+            checkpoint.record(chunk, stats)
+        for agent, agent_stats in zip(args.agent, stats):
+            cells[agent, num_players].merge(agent_stats)
+        counters = merge_counters(counters, chunk_counters)
+
+        done += 1
+        now = time.perf_counter()
+        if now - last_report >= progress_interval:
+            print(f"\r{done}/{len(chunks)} chunks", end="", file=sys.stderr, flush=True)
+            last_report = now
+
+    print(f"\r{done}/{len(chunks)} chunks", file=sys.stderr)
+    return cells, counters
+
+
+def parse_args():
+    parser = argparse.ArgumentParser(description="Simulate hanabi games")
+    parser.add_argument(
+        "--agent",
+        nargs="+",
+        default=[DEFAULT_AGENT],
+        help="agent modules, several run a tournament",
+    )
+    parser.add_argument(
+        "--compare",
+        metavar="AGENT",
+        help="play the same decks with a second agent and report paired differences",
+    )
+    parser.add_argument(
+        "--games", type=int, default=100000, help="maximum number of games"
+    )
+    parser.add_argument(
+        "--precision",
+        type=float,
+        help="stop once the 95%% confidence interval half width is below this",
+    )
+    parser.add_argument(
+        "--batch",
+        type=int,
+        default=10000,
+        help="games per round between precision checks",
+    )
+    parser.add_argument(
+        "--players",
+        type=int,
+        nargs="+",
+        default=[5],
+        help="player counts, several run a tournament",
+    )
+    parser.add_argument("--seed", type=int, default=0)
+    parser.add_argument("--chunksize", type=int, default=100)
+    parser.add_argument("--decks", help="deck corpus file, see hanasim.corpus")
+    parser.add_argument(
+        "--backend",
+        choices=list(BACKENDS),
+        default=DEFAULT_BACKEND,
+        help="board implementation, native needs numba to be compiled",
+    )
+    parser.add_argument(
+        "--vectorized",
+        action="store_true",
+        help="play each chunk in lockstep with the agent's BatchAgent",
+    )
+    parser.add_argument(
+        "--instrument", action="store_true", help="report time spent per phase"
+    )
+    parser.add_argument(
+        "--memory",
+        type=int,
+        default=0,
+        metavar="K",
+        help="trace the allocations of every K-th game of each worker and its RSS",
+    )
+    parser.add_argument(
+        "--executor",
+        choices=EXECUTORS,
+        default="local",
+        help="where chunks are played, see hanasim.executors",
+    )
+    parser.add_argument(
+        "--address",
+        help="HOST:PORT the socket executor listens on, or a Ray or Dask cluster",
+    )
+    parser.add_argument(
+        "--processes",
+        type=int,
+        help="local pool processes, or socket workers to wait for",
+    )
+    parser.add_argument(
+        "--checkpoint",
+        metavar="PATH",
+        help="record completed chunks in PATH and skip them when restarted "
+        "with the same agents, decks, chunking and engine",
+    )
+    parser.add_argument(
+        "--telemetry",
+        metavar="DIR",
+        help="write per-turn records to Parquet files in DIR, see hanasim.telemetry",
+    )
+    parser.add_argument(
+        "--action-logs",
+        metavar="PATH",
+        help="append the action log of every game, returned by the workers, to "
+        "PATH, which a --checkpoint resumes",
+    )
+    parser.add_argument(
+        "--keep-results",
+        action="store_true",
+        help="keep every game's result in shared memory and describe them",
+    )
+    args = parser.parse_args()
+
+    args.tournament = len(args.agent) > 1 or len(args.players) > 1
+    if args.tournament and (args.compare or args.precision or args.keep_results):
+        parser.error(
+            "--compare, --precision and --keep-results need a single agent "
+            "and player count"
+        )
+    if args.tournament and args.action_logs:
+        parser.error("--action-logs needs a single agent and player count")
+    if args.precision and args.batch < 1:
+        parser.error("--precision needs a --batch of at least one game")
+    if args.keep_results and args.executor not in ("serial", "local"):
+        parser.error("--keep-results needs the serial or local executor")
+    if args.checkpoint and args.keep_results:
+        parser.error("--keep-results cannot be restored from a --checkpoint")
+    if args.vectorized and (
+        args.tournament or args.compare or args.instrument or args.keep_results
+    ):
+        parser.error(
+            "--vectorized plays a single agent and player count without "
+            "--compare, --instrument or --keep-results"
+        )
+    if args.memory < 0:
+        parser.error("--memory needs a positive interval")
+    if args.memory and (args.instrument or args.vectorized):
+        parser.error("--memory cannot be combined with --instrument or --vectorized")
+    if args.telemetry and args.vectorized:
+        parser.error("--telemetry records the turns of unvectorized games only")
+    if args.telemetry and not ARROW:
+        parser.error("--telemetry needs pyarrow")
+    return args
+
+
+def run(args):
+    """Play the run described by the command line arguments and report it"""
+
+    N = args.games
+
+    # Decks of a corpus with a difficulty index are reported against it
+    index = None
+    if args.decks:
+        corpus = DeckCorpus(args.decks)
+        if len(corpus) < N:
+            raise SystemExit(f"{args.decks} holds only {len(corpus)} decks")
+        path = index_path(args.decks, args.players[0])
+        if args.keep_results and os.path.exists(path):
+            try:
+                index = DeckIndex(path, corpus)
+            except ValueError as error:
+                raise SystemExit(str(error))
+
+    agent_names = args.agent + [args.compare] if args.compare else args.agent
+
+    # The shared block is unlinked however the run ends
+    shared = SharedResults.create(N) if args.keep_results else nullcontext()
+    with shared as results:
+        initargs = (
+            agent_names,
+            results and results.name,
+            N,
+            args.decks,
+            args.instrument,
+            args.backend,
+            args.telemetry,
+            args.memory,
+            bool(args.action_logs),
+        )
+
+        # Chunks are only shared between runs that split and play them alike
+        checkpoint = None
+        if args.checkpoint:
+            config = {
+                "agents": agent_names,
+                "players": args.players,
+                "seed": args.seed,
+                "chunksize": args.chunksize,
+                "batch": args.batch,
+                "decks": args.decks,
+                "backend": args.backend,
+                "vectorized": args.vectorized,
+            }
+            try:
+                checkpoint = Checkpoint(args.checkpoint, config)
+            except ValueError as error:
+                raise SystemExit(str(error))
+
+        try:
+            executor = make_executor(
+                args.executor, init_worker, initargs, args.address, args.processes
+            )
+        except ValueError as error:
+            raise SystemExit(str(error))
+        if args.executor == "socket":
+            host, port = executor.address
+            print(f"Waiting for workers on {host}:{port}", file=sys.stderr)
+
+        with executor:
+            tic = time.perf_counter()
+            if args.tournament:
+                cells, counters = run_tournament(executor, args, checkpoint)
+            else:
+                logs = None
+                if args.action_logs:
+                    logs = open_logs(args.action_logs, checkpoint)
+                try:
+                    stats, counters = run_sweep(executor, args, checkpoint, logs)
+                finally:
+                    if logs is not None:
+                        logs.close()
+            toc = time.perf_counter()
+
+        if checkpoint is not None:
+            checkpoint.close()
+
+        if args.tournament:
+            print(results_table(cells))
+        else:
+            print(stats.summary())
+
+        if results is not None:
+            records = index.records[: stats.count] if index is not None else None
+            report(results.array[: stats.count], records)
+
+        if counters is not None:
+            print(counters.summary())
+
+        print(f"Time elapsed: {1000*(toc-tic)} ms")
+
+
+if __name__ == "__main__":
+    # Enter through the importable main module, so that executors on other
+    # machines can unpickle its task functions
+    import main
+
+    main.run(main.parse_args())